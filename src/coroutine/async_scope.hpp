@@ -0,0 +1,212 @@
+/**
+ * @file coroutine/async_scope.hpp
+ * @author github.com/luncliff (luncliff@gmail.com)
+ * @copyright CC BY 4.0
+ *
+ * @brief Structured concurrency. Spawn the coroutines in a scope, and `co_await` their end
+ */
+#pragma once
+#ifndef LUNCLIFF_COROUTINE_ASYNC_SCOPE_HPP
+#define LUNCLIFF_COROUTINE_ASYNC_SCOPE_HPP
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <utility>
+
+#include <coroutine/return.h>
+
+namespace coro {
+
+class async_scope;
+
+namespace internal {
+
+/**
+ * @brief Detached coroutine for `async_scope::spawn`. Starts immediately, and destroys its frame at the end
+ * @ingroup Scope
+ */
+struct scope_child final {
+    class promise_type final {
+        friend struct scope_child;
+
+        async_scope* scope = nullptr;
+
+      public:
+        template <typename... Args>
+        explicit promise_type(async_scope& owner, Args&&...) noexcept : scope{&owner} {
+        }
+
+        suspend_never initial_suspend() noexcept {
+            return {};
+        }
+        auto final_suspend() noexcept;
+        void unhandled_exception() noexcept;
+        constexpr void return_void() noexcept {
+        }
+        scope_child get_return_object() noexcept {
+            return {};
+        }
+    };
+};
+
+} // namespace internal
+
+/**
+ * @defgroup Scope
+ * Structured concurrency for the detached coroutines
+ */
+
+/**
+ * @brief Tracks the spawned coroutines with an atomic counter. `join()` suspends until all of them end.
+ *
+ * @details The awaiter of `join()` is counted too. So the joining coroutine is resumed exactly once,
+ * by the last child(or by itself if the children are done already). No thread is blocked for the join.
+ * The cancellation is cooperative. The children check `is_cancelled()`, and `spawn` after the cancel is ignored.
+ * The first exception from the children is rethrown by `join()`.
+ *
+ * While a `join()` is in flight, `spawn` is counted in the same join if a child is still running.
+ * (e.g. a child spawns its sibling) After the last child ends, `spawn` returns false until the joining
+ * coroutine is resumed. So a late child can never resume the joining coroutine again.
+ *
+ * @code
+ * async_scope scope{};
+ * for (auto& conn : connections)
+ *     scope.spawn(serve(conn)); // task<void>
+ * co_await scope.join();        // graceful shutdown
+ * @endcode
+ *
+ * @note `join()` must be awaited before the destruction if any coroutine was spawned
+ * @ingroup Scope
+ */
+class async_scope final {
+    friend class internal::scope_child::promise_type;
+
+    /// @brief `count` has this bit from the `join`'s suspend to its resume
+    static constexpr size_t joining = size_t{1} << (sizeof(size_t) * 8 - 1);
+
+    std::atomic<size_t> count{1}; /// spawned coroutines + the join(1 before it is awaited, or `joining`)
+    std::atomic<bool> cancelled{};
+    std::atomic<bool> failed{};
+    std::exception_ptr error{}; /// the first exception. written once by the `failed` winner
+    coroutine_handle<void> waiter = nullptr;
+
+  private:
+    /// @return the joining coroutine if this is the last arrival
+    coroutine_handle<void> arrive() noexcept {
+        if (count.fetch_sub(1, std::memory_order_acq_rel) == joining + 1)
+            return waiter;
+        return std::experimental::noop_coroutine();
+    }
+    void set_error(std::exception_ptr&& ex) noexcept {
+        if (failed.exchange(true, std::memory_order_relaxed) == false)
+            error = std::move(ex); // ordered by the `count` for the joining coroutine
+    }
+
+    template <typename A>
+    static internal::scope_child run(async_scope&, A awaitable) {
+        co_await std::move(awaitable);
+    }
+
+  public:
+    async_scope() noexcept = default;
+    async_scope(const async_scope&) = delete;
+    async_scope(async_scope&&) = delete;
+    async_scope& operator=(const async_scope&) = delete;
+    async_scope& operator=(async_scope&&) = delete;
+
+    /**
+     * @brief Start awaiting the awaitable(e.g. `task<void>`) in a detached coroutine of this scope
+     * @return false  The scope is cancelled, or its join is done and resuming. The awaitable is not started
+     * @throw The exception from the frame allocation or the awaitable's move. The scope doesn't count it
+     */
+    template <typename A>
+    bool spawn(A&& awaitable) noexcept(false) {
+        if (is_cancelled())
+            return false;
+        size_t expected = count.load(std::memory_order_relaxed);
+        do {
+            if (expected == joining) // no child to wait. the joining coroutine is (being) resumed
+                return false;
+        } while (count.compare_exchange_weak(expected, expected + 1, std::memory_order_relaxed) == false);
+        try {
+            run(*this, std::forward<A>(awaitable));
+        } catch (...) { // the child didn't start. `join()` may be waiting for this arrival
+            arrive().resume();
+            throw;
+        }
+        return true;
+    }
+
+    /// @brief Request the cooperative cancellation to the children
+    void cancel() noexcept {
+        cancelled.store(true, std::memory_order_release);
+    }
+    bool is_cancelled() const noexcept {
+        return cancelled.load(std::memory_order_acquire);
+    }
+    /// @brief number of the running children. Use it for the monitoring
+    size_t size() const noexcept {
+        const size_t value = count.load(std::memory_order_relaxed);
+        return value & joining ? value - joining : value - 1;
+    }
+
+    /**
+     * @brief Suspend until all spawned coroutines end. The scope can be reused after the join
+     * @note  Only one coroutine can join at a time
+     * @throw The first exception from the children
+     */
+    auto join() noexcept {
+        struct awaiter final {
+            async_scope& scope;
+
+            /// @note no child. `spawn` is rejected until the `await_resume`
+            bool await_ready() const noexcept {
+                size_t expected = 1;
+                return scope.count.compare_exchange_strong(expected, joining, std::memory_order_acq_rel);
+            }
+            bool await_suspend(coroutine_handle<void> coro) noexcept {
+                scope.waiter = coro;
+                // replace the join's 1 with the bit. the last child sees `joining + 1`
+                return scope.count.fetch_add(joining - 1, std::memory_order_acq_rel) != 1;
+            }
+            void await_resume() noexcept(false) {
+                scope.waiter = nullptr;
+                std::exception_ptr ex = nullptr;
+                if (scope.failed.exchange(false, std::memory_order_relaxed))
+                    ex = std::exchange(scope.error, nullptr);
+                // no child is running. put the join's 1 back for the next `spawn`
+                scope.count.fetch_sub(joining - 1, std::memory_order_release);
+                if (ex)
+                    std::rethrow_exception(ex);
+            }
+        };
+        return awaiter{*this};
+    }
+};
+
+namespace internal {
+
+inline auto scope_child::promise_type::final_suspend() noexcept {
+    struct awaiter final {
+        constexpr bool await_ready() const noexcept {
+            return false;
+        }
+        coroutine_handle<void> await_suspend(coroutine_handle<promise_type> coro) noexcept {
+            async_scope* scope = coro.promise().scope;
+            coro.destroy(); // suspended. nobody else refers this frame
+            return scope->arrive();
+        }
+        constexpr void await_resume() const noexcept {
+        }
+    };
+    return awaiter{};
+}
+
+inline void scope_child::promise_type::unhandled_exception() noexcept {
+    scope->set_error(std::current_exception());
+}
+
+} // namespace internal
+} // namespace coro
+
+#endif // LUNCLIFF_COROUTINE_ASYNC_SCOPE_HPP
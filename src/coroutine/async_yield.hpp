@@ -0,0 +1,146 @@
+/**
+ * @file coroutine/async_yield.hpp
+ * @author github.com/luncliff (luncliff@gmail.com)
+ * @copyright CC BY 4.0
+ *
+ * @brief `async_enumerable<T>`. Generator which can `co_await` between the `co_yield`s
+ */
+#pragma once
+#ifndef LUNCLIFF_COROUTINE_ASYNC_YIELD_HPP
+#define LUNCLIFF_COROUTINE_ASYNC_YIELD_HPP
+#include <exception>
+#include <memory>
+#include <utility>
+
+#include <coroutine/return.h>
+#include <coroutine/task.hpp>
+
+namespace coro {
+
+/**
+ * @brief Asynchronous generator. The body can `co_await` any awaitable, and the consumer awaits `next()`.
+ *
+ * @details The producer and the consumer transfer to each other with symmetric transfer.
+ * `next()` resumes the producer in place of the consumer, and `co_yield`/`co_return` resumes the consumer back.
+ * So the element is handed over without the stack growth and without any buffering.
+ * If the body is suspended by the other awaitable(e.g. socket, channel), the consumer is resumed by the thread
+ * which resumes the body later.
+ * The exception from the body is thrown by the `next()` which resumed it.
+ *
+ * @code
+ * auto pages(client_t& client) -> async_enumerable<item_t> {
+ *     for (auto token = first_page; token; ) {
+ *         page_t page = co_await client.fetch(token);
+ *         for (item_t& item : page.items)
+ *             co_yield item;
+ *         token = page.next;
+ *     }
+ * }
+ *
+ * auto consume(client_t& client) -> task<size_t> {
+ *     size_t count = 0;
+ *     auto items = pages(client);
+ *     while (item_t* item = co_await items.next())
+ *         count += item->size;
+ *     co_return count;
+ * }
+ * @endcode
+ *
+ * @note The frame is from the `frame_arena` if the function has its reference parameter. (same with `task`)
+ * @tparam T Type of the element
+ * @ingroup Task
+ */
+template <typename T>
+class async_enumerable final {
+  public:
+    using value_type = T;
+    using reference = value_type&;
+    using pointer = value_type*;
+
+    class promise_type final : public internal::task_promise_base {
+        friend class async_enumerable;
+
+        pointer current = nullptr;
+        std::exception_ptr error{};
+
+      public:
+        async_enumerable get_return_object() noexcept {
+            return async_enumerable{coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        void unhandled_exception() noexcept {
+            current = nullptr;
+            error = std::current_exception();
+        }
+        /// @brief  `co_yield` expression. The consumer continues with the reference
+        internal::task_final_awaiter yield_value(reference ref) noexcept {
+            current = std::addressof(ref);
+            return {};
+        }
+        /// @brief  `co_yield` expression. for r-value. It lives until the next resumption
+        internal::task_final_awaiter yield_value(value_type&& v) noexcept {
+            return yield_value(v);
+        }
+        void return_void() noexcept {
+            current = nullptr;
+        }
+    };
+
+  private:
+    coroutine_handle<promise_type> coro = nullptr;
+
+  public:
+    async_enumerable() noexcept = default;
+    explicit async_enumerable(coroutine_handle<promise_type> handle) noexcept : coro{handle} {
+    }
+    ~async_enumerable() noexcept {
+        if (coro)
+            coro.destroy();
+    }
+    async_enumerable(const async_enumerable&) = delete;
+    async_enumerable& operator=(const async_enumerable&) = delete;
+    async_enumerable(async_enumerable&& rhs) noexcept : coro{std::exchange(rhs.coro, nullptr)} {
+    }
+    async_enumerable& operator=(async_enumerable&& rhs) noexcept {
+        std::swap(coro, rhs.coro);
+        return *this;
+    }
+
+  public:
+    /// @return true if the body has finished. `next()` returns `nullptr` without the suspension
+    bool is_done() const noexcept {
+        return coro == nullptr || coro.done();
+    }
+
+    /**
+     * @brief Resume the body until its next `co_yield` or the end
+     * @return awaitable of `pointer`. `nullptr` at the end
+     * @throw The exception from the body. (with `co_await`)
+     * @note Only one consumer can await at a time
+     */
+    auto next() noexcept {
+        struct awaiter final {
+            coroutine_handle<promise_type> coro;
+
+            bool await_ready() const noexcept {
+                return coro == nullptr || coro.done();
+            }
+            coroutine_handle<void> await_suspend(coroutine_handle<void> consumer) noexcept {
+                coro.promise().set_continuation(consumer);
+                return coro;
+            }
+            pointer await_resume() noexcept(false) {
+                if (coro == nullptr)
+                    return nullptr;
+                promise_type& p = coro.promise();
+                if (p.error)
+                    std::rethrow_exception(std::exchange(p.error, nullptr));
+                return p.current;
+            }
+        };
+        return awaiter{coro};
+    }
+};
+
+} // namespace coro
+
+#endif // LUNCLIFF_COROUTINE_ASYNC_YIELD_HPP
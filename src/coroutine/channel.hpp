@@ -8,8 +8,16 @@
 #pragma once
 #ifndef LUNCLIFF_COROUTINE_CHANNEL_HPP
 #define LUNCLIFF_COROUTINE_CHANNEL_HPP
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
 #include <mutex>
+#include <optional>
 #include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #if __has_include(<coroutine/frame.h>) && !defined(USE_EXPERIMENTAL_COROUTINE)
 #include <coroutine/frame.h>
@@ -44,6 +52,12 @@ using std::experimental::suspend_never;
  * If user code can become mess because of such relationship,
  * it is strongly recommended to hide `channel` internally and open their own interfaces.
  *
+ * The matched coroutines are never resumed in a nested manner.
+ * When a `channel_writer` finds a waiting `channel_reader`, it suspends and leaves its handle to the reader,
+ * then posts the reader to `internal::handoff_queue` of the current thread.
+ * When a `channel_reader` finds a waiting `channel_writer` (or is resumed by one), it takes the value and posts the writer.
+ * So the reader always receives the value before the writer continues, and the stack depth is bounded.
+ * `channel_borrower` posts the writer when its `channel_borrow` ends instead.
  */
 
 /**
@@ -64,8 +78,92 @@ struct bypass_mutex final {
     }
 };
 
+/**
+ * @brief Counters of a `channel`. Collected only if its mutex is `instrumented<M>`
+ * @see instrumented
+ * @ingroup channel
+ */
+struct channel_stats final {
+    static constexpr size_t bucket_count = 32;
+
+    struct side_t final {
+        uint64_t depth = 0;     /// Current number of the waiting operations
+        uint64_t peak = 0;      /// Maximum of the `depth`
+        uint64_t fast = 0;      /// Matched with a waiting peer. No wait in the channel
+        uint64_t suspended = 0; /// Waited in the channel for a peer
+    };
+    side_t readers{};
+    side_t writers{};
+    uint64_t transfers = 0; /// Number of the delivered values
+    /**
+     * @brief `wait[i]` counts the waits in [2^i, 2^(i+1)) nanoseconds.
+     *        The last bucket includes all longer waits
+     */
+    uint64_t wait[bucket_count]{};
+
+    static constexpr size_t bucket_of(uint64_t ns) noexcept {
+        size_t i = 0;
+        while (ns > 1 && i + 1 < bucket_count) {
+            ns >>= 1;
+            ++i;
+        }
+        return i;
+    }
+};
+
+/**
+ * @brief Lockable adapter which makes `channel` collect `channel_stats`.
+ *        The other mutex types don't have the counters and the cost of the collection.
+ *
+ * @code
+ * channel<int, instrumented<mutex>> ch{};
+ * // ...
+ * channel_stats s = ch.stats();
+ * if (s.writers.peak > 100)
+ *     ; // the consumer stage is the bottleneck
+ * @endcode
+ *
+ * @tparam M the mutex(lockable) to wrap
+ * @ingroup channel
+ */
+template <typename M>
+class instrumented final {
+    M mtx{};
+
+  public:
+    channel_stats stats{}; /// Guarded by this lockable
+
+  public:
+    bool try_lock() noexcept(false) {
+        return mtx.try_lock();
+    }
+    void lock() noexcept(false) {
+        mtx.lock();
+    }
+    void unlock() noexcept(false) {
+        mtx.unlock();
+    }
+};
+
 namespace internal {
 
+template <typename M>
+struct is_instrumented : std::false_type {};
+template <typename M>
+struct is_instrumented<instrumented<M>> : std::true_type {};
+
+/**
+ * @brief The time when the waiter is parked in its channel.
+ *        Empty(no storage with the base class optimization) unless the channel is instrumented
+ * @ingroup channel
+ */
+template <bool Enable>
+struct wait_stamp {};
+template <>
+struct wait_stamp<true> {
+    std::chrono::steady_clock::time_point parked_at{};
+};
+
 /**
  * @brief Returns a non-null address that leads access violation
  * @note Notice that `reinterpret_cast` is not constexpr for some compiler.
@@ -96,6 +194,12 @@ class list {
         } else
             head = tail = node;
     }
+    /**
+     * @return T* The first node without pop. The return can be `nullptr`
+     */
+    auto peek() const noexcept -> T* {
+        return head;
+    }
     /**
      * @return T* The return can be `nullptr`
      */
@@ -107,9 +211,199 @@ class list {
             head = head->next;
         return node;
     }
+    /**
+     * @brief Unlink the node from any position. O(n) search
+     * @return false  The node is not in the list. (Someone has popped it)
+     */
+    bool erase(T* node) noexcept {
+        T* prev = nullptr;
+        for (T* it = head; it != nullptr; prev = it, it = (it == tail) ? nullptr : it->next) {
+            if (it != node)
+                continue;
+            if (it == tail) { // the `next` of tail is not maintained
+                tail = prev;
+                if (prev == nullptr)
+                    head = nullptr;
+            } else if (prev)
+                prev->next = it->next;
+            else
+                head = it->next;
+            return true;
+        }
+        return false;
+    }
+};
+
+/**
+ * @brief Thread-local FIFO of the coroutines that are ready to continue after a channel's matching
+ * @note  The first `post` in the thread becomes the trampoline which drains the queue.
+ *        The other requests in the thread (while draining) are simply enqueued.
+ *        This keeps the native stack depth bounded for long read/write chains.
+ * @ingroup channel
+ */
+class handoff_queue final {
+    std::deque<coroutine_handle<void>> tasks{};
+    bool draining = false;
+
+  private:
+    void drain() noexcept(false) {
+        struct trampoline_t final {
+            bool& draining;
+            explicit trampoline_t(bool& flag) noexcept : draining{flag} {
+                draining = true;
+            }
+            ~trampoline_t() noexcept {
+                draining = false; // even if the resumed coroutine throws
+            }
+        } trampoline{draining};
+        while (tasks.empty() == false) {
+            auto task = tasks.front();
+            tasks.pop_front();
+            task.resume();
+        }
+    }
+
+  public:
+    static handoff_queue& current() noexcept {
+        thread_local handoff_queue queue{};
+        return queue;
+    }
+
+    /**
+     * @brief Resume the coroutine after the current one suspends.
+     *        If there is no trampoline in the thread, resume it now
+     */
+    void post(coroutine_handle<void> task) noexcept(false) {
+        tasks.push_back(task);
+        if (draining == false)
+            drain();
+    }
+};
+
+/**
+ * @brief Registration of a deadline-bounded channel operation in `deadline_queue`
+ * @note  `state` is guarded by the channel's mutex. `position` and `linked` are guarded by the queue's mutex
+ * @ingroup channel
+ */
+struct deadline_node {
+    using clock_type = std::chrono::steady_clock;
+    using time_point = clock_type::time_point;
+    using map_type = std::multimap<time_point, deadline_node*>;
+    /**
+     * @brief Unlink the operation from its channel. Invoked by `deadline_queue::poll`
+     * @return void* The coroutine to resume with timeout. `nullptr` if a peer has taken the operation
+     */
+    using unlink_fn = void* (*)(deadline_node*);
+
+    enum state_t : uint32_t {
+        pending = 0, /// Not in the channel yet
+        parked = 1,  /// Waiting in the channel
+        expired = 2, /// The deadline has passed before it parks
+    };
+
+    time_point deadline;
+    unlink_fn unlink;
+    state_t state = pending;
+    bool linked = false;
+    map_type::iterator position{};
+
+    deadline_node(time_point tp, unlink_fn fn) noexcept : deadline{tp}, unlink{fn} {
+    }
 };
+
 } // namespace internal
 
+/**
+ * @brief Result of the deadline-bounded channel operations
+ * @ingroup channel
+ */
+enum class channel_status : uint32_t {
+    success = 0,   /// The value is delivered
+    closed = 1,    /// The channel is under destruction
+    timed_out = 2, /// The deadline has passed before the peer shows up
+};
+
+/**
+ * @brief Timer list for `channel::read_until`/`channel::write_until`.
+ *        The owner thread must `poll` it periodically (like `poll_net_tasks`)
+ *
+ * @code
+ * while (running) {
+ *     deadline_queue::global().poll(); // resumes the expired operations
+ *     // ... other works of the event loop
+ * }
+ * @endcode
+ *
+ * @note The mutex of this queue is acquired before the channel's mutex. Never the reverse order.
+ * @ingroup channel
+ */
+class deadline_queue final {
+  public:
+    using clock_type = internal::deadline_node::clock_type;
+    using time_point = internal::deadline_node::time_point;
+
+  private:
+    std::mutex mtx{};
+    internal::deadline_node::map_type nodes{};
+
+  public:
+    /**
+     * @brief The default queue for the deadline-bounded operations
+     */
+    static deadline_queue& global() noexcept {
+        static deadline_queue queue{};
+        return queue;
+    }
+
+    void insert(internal::deadline_node* node) noexcept(false) {
+        std::unique_lock lck{mtx};
+        node->position = nodes.emplace(node->deadline, node);
+        node->linked = true;
+    }
+    /**
+     * @brief Remove the node if it is not polled yet.
+     *        After the return, `poll` never accesses the node
+     */
+    void erase(internal::deadline_node* node) noexcept(false) {
+        std::unique_lock lck{mtx};
+        if (node->linked == false)
+            return;
+        nodes.erase(node->position);
+        node->linked = false;
+    }
+    /**
+     * @return time_point The earliest deadline. `nullopt` if there is nothing to wait
+     */
+    auto next() noexcept(false) -> std::optional<time_point> {
+        std::unique_lock lck{mtx};
+        if (nodes.empty())
+            return std::nullopt;
+        return nodes.begin()->first;
+    }
+    /**
+     * @brief Unlink the operations whose deadline has passed from their channels,
+     *        and resume them with `channel_status::timed_out`
+     * @note  The coroutines are resumed in this thread after the queue is unlocked
+     * @return size_t The number of timed out operations
+     */
+    size_t poll(time_point now = clock_type::now()) noexcept(false) {
+        std::vector<coroutine_handle<void>> expired{};
+        {
+            std::unique_lock lck{mtx};
+            const auto last = nodes.upper_bound(now);
+            for (auto it = nodes.begin(); it != last; it = nodes.erase(it)) {
+                internal::deadline_node* node = it->second;
+                node->linked = false;
+                if (void* frame = node->unlink(node))
+                    expired.emplace_back(coroutine_handle<void>::from_address(frame));
+            }
+        }
+        for (auto coro : expired)
+            internal::handoff_queue::current().post(coro);
+        return expired.size();
+    }
+};
+
 template <typename T, typename M = bypass_mutex>
 class channel; // by default, channel doesn't care about the race condition
 template <typename T, typename M>
@@ -118,6 +412,73 @@ template <typename T, typename M>
 class channel_writer;
 template <typename T, typename M>
 class channel_peeker;
+template <typename T, typename M>
+class channel_borrower;
+template <typename T, typename M>
+class channel_optional_reader;
+template <typename T, typename M>
+class channel_timed_reader;
+template <typename T, typename M>
+class channel_timed_writer;
+
+/**
+ * @brief Reference to the value of suspended `channel_writer`.
+ *        The writer is resumed when the borrow ends (destruction or `release`)
+ *
+ * @tparam T type of the element
+ * @see channel_borrower
+ * @ingroup channel
+ */
+template <typename T>
+class channel_borrow final {
+    T* ptr = nullptr;      /// Address of the writer's value
+    void* frame = nullptr; /// The writer to resume when the borrow ends
+
+  public:
+    /** @brief Empty borrow. The channel is under destruction */
+    channel_borrow() noexcept = default;
+    channel_borrow(T* value, void* writer) noexcept : ptr{value}, frame{writer} {
+    }
+    ~channel_borrow() noexcept(false) {
+        release();
+    }
+    channel_borrow(const channel_borrow&) = delete;
+    channel_borrow& operator=(const channel_borrow&) = delete;
+    channel_borrow(channel_borrow&& rhs) noexcept : ptr{rhs.ptr}, frame{rhs.frame} {
+        rhs.ptr = nullptr;
+        rhs.frame = nullptr;
+    }
+    channel_borrow& operator=(channel_borrow&& rhs) noexcept(false) {
+        release();
+        std::swap(ptr, rhs.ptr);
+        std::swap(frame, rhs.frame);
+        return *this;
+    }
+
+  public:
+    /**
+     * @brief End the borrow and resume the writer coroutine
+     * @note  The reference is invalid after this call
+     */
+    void release() noexcept(false) {
+        ptr = nullptr;
+        if (auto coro = coroutine_handle<void>::from_address(std::exchange(frame, nullptr)))
+            internal::handoff_queue::current().post(coro);
+    }
+
+    /**
+     * @return false  The channel is under destruction. Nothing is borrowed
+     */
+    explicit operator bool() const noexcept {
+        return ptr != nullptr;
+    }
+    T& operator*() const noexcept {
+        return *ptr;
+    }
+    T* operator->() const noexcept {
+        return ptr;
+    }
+};
 
 /**
  * @brief Awaitable type for `channel`'s read operation.
@@ -137,7 +498,7 @@ class channel_peeker;
  * @ingroup channel
  */
 template <typename T, typename M>
-class channel_reader {
+class channel_reader : protected internal::wait_stamp<internal::is_instrumented<M>::value> {
   public:
     using value_type = T;
     using pointer = T*;
@@ -188,6 +549,7 @@ class channel_reader {
             return false;
 
         writer* w = chan->writer_list::pop();
+        chan->count_take(w, this);
         // exchange address & resumeable_handle
         std::swap(this->ptr, w->ptr);
         std::swap(this->frame, w->frame);
@@ -208,27 +570,31 @@ class channel_reader {
         this->frame = coro.address();
         this->next = nullptr;
         // push to channel
+        ch.count_park(this);
         ch.reader_list::push(this);
         ch.mtx.unlock();
     }
     /**
      * @brief Returns value from writer coroutine, and `bool` indicator for the associtated channel's destruction
+     * @note  The writer coroutine is posted to `internal::handoff_queue` after the move
      *
      * @return tuple<value_type, bool>
      */
     auto await_resume() noexcept(false) -> std::tuple<value_type, bool> {
-        auto t = std::make_tuple(value_type{}, false);
         // frame holds poision if the channel is under destruction
         if (this->frame == internal::poison())
-            return t;
-        // the resume operation can destroy the other coroutine
-        // store before resume
-        std::get<0>(t) = std::move(*ptr);
-        if (auto coro = coro::coroutine_handle<void>::from_address(frame))
-            coro.resume();
-        std::get<1>(t) = true;
+            return std::make_tuple(value_type{}, false);
+        // the writer can destroy the value after its resume. store before post
+        auto t = std::make_tuple(std::move(*ptr), true);
+        post_writer();
         return t;
     }
+
+  protected:
+    void post_writer() noexcept(false) {
+        if (auto coro = coro::coroutine_handle<void>::from_address(frame))
+            internal::handoff_queue::current().post(coro);
+    }
 };
 
 /**
@@ -249,7 +615,7 @@ class channel_reader {
  * @ingroup channel
  */
 template <typename T, typename M>
-class channel_writer {
+class channel_writer : protected internal::wait_stamp<internal::is_instrumented<M>::value> {
   public:
     using value_type = T;
     using pointer = T*;
@@ -267,7 +633,7 @@ class channel_writer {
     friend writer_list;
     friend peeker; // for `peek()` implementation
 
-  private:
+  protected:
     mutable pointer ptr; /// Address of value
     mutable void* frame; /// Resumeable Handle
     union {
@@ -275,7 +641,7 @@ class channel_writer {
         channel_type* chan;             /// Channel to push this writer
     };
 
-  private:
+  protected:
     explicit channel_writer(channel_type& ch, pointer pv) noexcept(false)
         : ptr{pv}, frame{nullptr}, chan{std::addressof(ch)} {
     }
@@ -289,41 +655,28 @@ class channel_writer {
 
   public:
     /**
-     * @brief Lock the channel and find available `channel_reader`
-     *
-     * @return true   Matched with `channel_reader`
-     * @return false  There was no available `channel_reader`.
-     *                The channel will be **lock**ed for this case.
+     * @brief The writer always suspends. The value must be moved by the reader before this writer continues.
+     * @return false
      */
-    bool await_ready() const noexcept(false) {
-        chan->mtx.lock();
-        if (chan->reader_list::is_empty())
-            // await_suspend will unlock in the case
-            return false;
-
-        reader* r = chan->reader_list::pop();
-        // exchange address & resumeable_handle
-        std::swap(this->ptr, r->ptr);
-        std::swap(this->frame, r->frame);
-
-        chan->mtx.unlock();
-        return true;
+    constexpr bool await_ready() const noexcept {
+        return false;
     }
     /**
-     * @brief Push to the channel and wait for `channel_reader`.
+     * @brief Lock the channel and find available `channel_reader`.
+     *        If there is no reader, push to the channel and wait for `channel_reader`.
      * @note  The channel will be **unlock**ed after return.
+     *        If matched, this writer is posted by the reader after it takes the value.
+     *        So this coroutine may be resumed before the return of this function.
      * @param coro Remember current coroutine's handle to resume later
-     * @see await_ready
+     * @see internal::handoff_queue
      */
     void await_suspend(coro::coroutine_handle<void> coro) noexcept(false) {
         // notice that next & chan are sharing memory
         channel_type& ch = *(this->chan);
-
-        this->frame = coro.address(); // remember handle before push/unlock
-        this->next = nullptr;         // clear to prevent confusing
-
-        ch.writer_list::push(this); // push to channel
-        ch.mtx.unlock();
+        ch.mtx.lock();
+        if (handoff(ch, coro))
+            return;
+        park(ch, coro);
     }
     /**
      * @brief Returns `bool` indicator for the associtated channel's destruction
@@ -331,14 +684,43 @@ class channel_writer {
      * @return true   successfully sent the value to `channel_reader`
      * @return false  The `channel` is under destruction
      */
-    bool await_resume() noexcept(false) {
+    bool await_resume() const noexcept {
         // frame holds poision if the channel is under destruction
-        if (this->frame == internal::poison())
+        return this->frame != internal::poison();
+    }
+
+  protected:
+    /**
+     * @brief Give the value and this writer to the waiting reader
+     * @note  Requires the lock. Unlocks the channel if matched
+     * @return false  There was no reader. The channel is still **lock**ed
+     */
+    bool handoff(channel_type& ch, coro::coroutine_handle<void> coro) noexcept(false) {
+        if (ch.reader_list::is_empty())
             return false;
-        if (auto coro = coro::coroutine_handle<void>::from_address(frame))
-            coro.resume();
+        reader* r = ch.reader_list::pop();
+        ch.count_take(r, this);
+        auto rh = coro::coroutine_handle<void>::from_address(r->frame);
+        r->ptr = this->ptr;
+        r->frame = coro.address();
+        this->frame = nullptr;
+        ch.mtx.unlock();
+        // don't access the members after this line. the writer can be resumed in the post
+        internal::handoff_queue::current().post(rh);
         return true;
     }
+    /**
+     * @brief Push to the channel and wait for `channel_reader`
+     * @note  Requires the lock. The channel will be **unlock**ed after return
+     */
+    void park(channel_type& ch, coro::coroutine_handle<void> coro) noexcept(false) {
+        this->frame = coro.address(); // remember handle before push/unlock
+        this->next = nullptr;         // clear to prevent confusing
+
+        ch.count_park(this);
+        ch.writer_list::push(this); // push to channel
+        ch.mtx.unlock();
+    }
 };
 
 /**
@@ -368,14 +750,61 @@ class channel final : internal::list<channel_reader<T, M>>,
     using writer = channel_writer<value_type, mutex_type>;
     using writer_list = internal::list<writer>;
     using peeker = channel_peeker<value_type, mutex_type>;
+    using timed_reader = channel_timed_reader<value_type, mutex_type>;
+    using timed_writer = channel_timed_writer<value_type, mutex_type>;
 
     friend reader;
     friend writer;
     friend peeker; // for `peek()` implementation
+    friend timed_reader;
+    friend timed_writer;
 
   private:
     mutex_type mtx{};
 
+  private:
+    // statistics for `instrumented<M>`. They require the lock, and do nothing for the other mutex types
+
+    auto side_of(const reader*) noexcept -> channel_stats::side_t& {
+        return mtx.stats.readers;
+    }
+    auto side_of(const writer*) noexcept -> channel_stats::side_t& {
+        return mtx.stats.writers;
+    }
+    /// @brief `waiter` is pushed to the channel
+    template <typename W>
+    void count_park(W* waiter) noexcept {
+        if constexpr (internal::is_instrumented<M>::value) {
+            channel_stats::side_t& side = side_of(waiter);
+            side.suspended += 1;
+            if (++side.depth > side.peak)
+                side.peak = side.depth;
+            waiter->parked_at = std::chrono::steady_clock::now();
+        }
+    }
+    /// @brief `waiter` is popped by `peer` which didn't wait
+    template <typename W, typename P>
+    void count_take(const W* waiter, const P* peer) noexcept {
+        if constexpr (internal::is_instrumented<M>::value) {
+            using namespace std::chrono;
+            side_of(waiter).depth -= 1;
+            side_of(peer).fast += 1;
+            mtx.stats.transfers += 1;
+            const auto ns = duration_cast<nanoseconds>(steady_clock::now() - waiter->parked_at).count();
+            mtx.stats.wait[channel_stats::bucket_of(static_cast<uint64_t>(ns))] += 1;
+        }
+    }
+    /// @brief `waiter` is erased without transfer
+    template <typename W>
+    void count_leave(const W* waiter) noexcept {
+        if constexpr (internal::is_instrumented<M>::value)
+            side_of(waiter).depth -= 1;
+    }
+    void count_close() noexcept {
+        if constexpr (internal::is_instrumented<M>::value)
+            mtx.stats.readers.depth = mtx.stats.writers.depth = 0;
+    }
+
   private:
     channel(const channel&) noexcept(false) = delete;
     channel(channel&&) noexcept(false) = delete;
@@ -403,15 +832,23 @@ class channel final : internal::list<channel_reader<T, M>>,
      * Current implementation allows checking repeatedly to reduce the
      * probability of such interleaving.
      * **Modify the repeat count in the code** if the situation occurs.
+     *
+     * The waiting coroutines are detached under the lock, and resumed after the unlock.
+     * So `deadline_queue` (which locks the channel in its `poll`) can't be deadlocked with this.
      */
     ~channel() noexcept(false) {
         void* closing = internal::poison();
-        writer_list& writers = *this;
-        reader_list& readers = *this;
         // even 5'000+ can be unsafe for hazard usage ...
         size_t repeat = 1;
         do {
-            std::unique_lock lck{mtx};
+            writer_list writers{};
+            reader_list readers{};
+            {
+                std::unique_lock lck{mtx};
+                std::swap(writers, static_cast<writer_list&>(*this));
+                std::swap(readers, static_cast<reader_list&>(*this));
+                count_close();
+            }
             while (writers.is_empty() == false) {
                 writer* w = writers.pop();
                 auto coro = coro::coroutine_handle<void>::from_address(w->frame);
@@ -447,6 +884,290 @@ class channel final : internal::list<channel_reader<T, M>>,
     decltype(auto) read() noexcept(false) {
         return channel_reader{*this};
     }
+    /**
+     * @brief construct a new reader which lends the writer's value without move
+     *
+     * @return channel_borrower
+     */
+    decltype(auto) borrow() noexcept(false) {
+        return channel_borrower<value_type, mutex_type>{*this};
+    }
+    /**
+     * @brief construct a new reader which returns `optional<T>`. `T` doesn't have to be default constructible
+     *
+     * @return channel_optional_reader
+     */
+    decltype(auto) read_optional() noexcept(false) {
+        return channel_optional_reader<value_type, mutex_type>{*this};
+    }
+    /**
+     * @brief construct a new writer which gives up at the deadline
+     *
+     * @param ref `T&` which holds a value to be `move`d to reader.
+     * @param deadline The operation returns `channel_status::timed_out` after this
+     * @param timers The queue to register the deadline. Someone must `poll` it
+     * @return channel_timed_writer
+     */
+    decltype(auto) write_until(reference ref, deadline_queue::time_point deadline,
+                               deadline_queue& timers = deadline_queue::global()) noexcept(false) {
+        return timed_writer{*this, std::addressof(ref), deadline, timers};
+    }
+    /**
+     * @brief construct a new reader which gives up at the deadline
+     *
+     * @param deadline The operation returns `channel_status::timed_out` after this
+     * @param timers The queue to register the deadline. Someone must `poll` it
+     * @return channel_timed_reader
+     */
+    decltype(auto) read_until(deadline_queue::time_point deadline,
+                              deadline_queue& timers = deadline_queue::global()) noexcept(false) {
+        return timed_reader{*this, deadline, timers};
+    }
+    /**
+     * @brief Copy of the counters. Available when the mutex type is `instrumented<M>`
+     * @return channel_stats
+     */
+    auto stats() noexcept(false) -> channel_stats {
+        static_assert(internal::is_instrumented<M>::value, "requires `instrumented<M>` for the mutex type");
+        std::unique_lock lck{mtx};
+        return mtx.stats;
+    }
+};
+
+/**
+ * @brief Awaitable for `channel`'s borrowing read operation.
+ *        The writer coroutine stays suspended until the returned `channel_borrow` ends.
+ *
+ * @code
+ * void inspect(channel<message_t>& ch) {
+ *     auto msg = co_await ch.borrow();
+ *     if(!msg)
+ *         ; // channel is under destruction !!!
+ *     consume(*msg); // no copy/move of `message_t`
+ * }   // the writer is resumed here
+ * @endcode
+ *
+ * @tparam T type of the element
+ * @tparam M mutex for the channel
+ * @see channel_reader
+ * @ingroup channel
+ */
+template <typename T, typename M>
+class channel_borrower final : protected channel_reader<T, M> {
+    using channel_type = channel<T, M>;
+    friend channel_type;
+
+  private:
+    explicit channel_borrower(channel_type& ch) noexcept(false) : channel_reader<T, M>{ch} {
+    }
+
+  public:
+    using channel_reader<T, M>::await_ready;
+    using channel_reader<T, M>::await_suspend;
+    /**
+     * @return channel_borrow<T> Reference to the writer's value. Empty if the channel is under destruction
+     */
+    auto await_resume() noexcept -> channel_borrow<T> {
+        if (this->frame == internal::poison())
+            return {};
+        return {this->ptr, this->frame};
+    }
+};
+
+/**
+ * @brief Awaitable for `channel`'s read operation, which constructs the value in place.
+ *        It doesn't require default constructor of `T`.
+ *
+ * @tparam T type of the element
+ * @tparam M mutex for the channel
+ * @see channel_reader
+ * @ingroup channel
+ */
+template <typename T, typename M>
+class channel_optional_reader final : protected channel_reader<T, M> {
+    using channel_type = channel<T, M>;
+    friend channel_type;
+
+  private:
+    explicit channel_optional_reader(channel_type& ch) noexcept(false) : channel_reader<T, M>{ch} {
+    }
+
+  public:
+    using channel_reader<T, M>::await_ready;
+    using channel_reader<T, M>::await_suspend;
+    /**
+     * @return optional<T> `nullopt` if the channel is under destruction
+     */
+    auto await_resume() noexcept(false) -> std::optional<T> {
+        if (this->frame == internal::poison())
+            return std::nullopt;
+        std::optional<T> value{std::in_place, std::move(*this->ptr)};
+        this->post_writer();
+        return value;
+    }
+};
+
+/**
+ * @brief Awaitable for `channel`'s read operation with a deadline.
+ *
+ * @details The reader is registered in `deadline_queue` before it locks the channel.
+ * When the queue is polled after the deadline, it locks the channel and erases the reader from the channel's list.
+ * Whoever takes the reader first under the channel's lock wins, so the race with a writer is resolved there.
+ * The erased reader is resumed with `channel_status::timed_out` and its frame is not held by the channel anymore.
+ *
+ * @code
+ * auto consume(channel<int, mutex>& ch) -> frame_t {
+ *     auto deadline = chrono::steady_clock::now() + 100ms;
+ *     auto [value, status] = co_await ch.read_until(deadline);
+ *     if(status == channel_status::timed_out)
+ *         ; // no writer until the deadline
+ * }
+ * @endcode
+ *
+ * @tparam T type of the element
+ * @tparam M mutex for the channel
+ * @see deadline_queue
+ * @ingroup channel
+ */
+template <typename T, typename M>
+class channel_timed_reader final : protected channel_reader<T, M>, private internal::deadline_node {
+    using channel_type = channel<T, M>;
+    using reader = channel_reader<T, M>;
+    using reader_list = typename channel_type::reader_list;
+    using value_type = T;
+    friend channel_type;
+
+    channel_type& owner;     /// `chan` of the base is overwritten when parked
+    deadline_queue& timers;  /// Where this reader is registered
+    channel_status status{}; /// `timed_out` if `unlink` erased this reader
+
+  private:
+    channel_timed_reader(channel_type& ch, time_point deadline, deadline_queue& q) noexcept(false)
+        : reader{ch}, internal::deadline_node{deadline, &unlink}, owner{ch}, timers{q} {
+    }
+
+    static void* unlink(internal::deadline_node* node) noexcept(false) {
+        auto* self = static_cast<channel_timed_reader*>(node);
+        std::unique_lock lck{self->owner.mtx};
+        if (self->state == pending) {
+            self->state = expired; // await_suspend will see this
+            return nullptr;
+        }
+        if (self->owner.reader_list::erase(self) == false)
+            return nullptr; // a writer took this reader
+        self->owner.count_leave(static_cast<reader*>(self));
+        self->status = channel_status::timed_out;
+        return self->frame;
+    }
+
+  public:
+    /**
+     * @brief Register the deadline and try to match with `channel_writer`
+     * @see channel_reader::await_ready
+     */
+    bool await_ready() noexcept(false) {
+        timers.insert(this);
+        return reader::await_ready();
+    }
+    /**
+     * @brief Push to the channel unless the deadline has passed
+     * @return false  Timed out without suspension
+     */
+    bool await_suspend(coroutine_handle<void> coro) noexcept(false) {
+        if (this->state == expired || this->deadline <= clock_type::now()) {
+            owner.mtx.unlock();
+            status = channel_status::timed_out;
+            return false;
+        }
+        this->state = parked;
+        reader::await_suspend(coro);
+        return true;
+    }
+    /**
+     * @return tuple<value_type, channel_status>
+     */
+    auto await_resume() noexcept(false) -> std::tuple<value_type, channel_status> {
+        timers.erase(this);
+        if (this->frame == internal::poison())
+            return std::make_tuple(value_type{}, channel_status::closed);
+        if (status == channel_status::timed_out)
+            return std::make_tuple(value_type{}, status);
+        auto t = std::make_tuple(std::move(*this->ptr), channel_status::success);
+        this->post_writer();
+        return t;
+    }
+};
+
+/**
+ * @brief Awaitable for `channel`'s write operation with a deadline.
+ *        The value is not moved if the operation is timed out.
+ *
+ * @tparam T type of the element
+ * @tparam M mutex for the channel
+ * @see channel_timed_reader
+ * @ingroup channel
+ */
+template <typename T, typename M>
+class channel_timed_writer final : protected channel_writer<T, M>, private internal::deadline_node {
+    using channel_type = channel<T, M>;
+    using writer = channel_writer<T, M>;
+    using writer_list = typename channel_type::writer_list;
+    using pointer = T*;
+    friend channel_type;
+
+    channel_type& owner;     /// `chan` of the base is overwritten when parked
+    deadline_queue& timers;  /// Where this writer is registered
+    channel_status status{}; /// `timed_out` if `unlink` erased this writer
+
+  private:
+    channel_timed_writer(channel_type& ch, pointer pv, time_point deadline, deadline_queue& q) noexcept(false)
+        : writer{ch, pv}, internal::deadline_node{deadline, &unlink}, owner{ch}, timers{q} {
+    }
+
+    static void* unlink(internal::deadline_node* node) noexcept(false) {
+        auto* self = static_cast<channel_timed_writer*>(node);
+        std::unique_lock lck{self->owner.mtx};
+        if (self->state == pending) {
+            self->state = expired; // await_suspend will see this
+            return nullptr;
+        }
+        if (self->owner.writer_list::erase(self) == false)
+            return nullptr; // a reader took this writer
+        self->owner.count_leave(static_cast<writer*>(self));
+        self->status = channel_status::timed_out;
+        return self->frame;
+    }
+
+  public:
+    using writer::await_ready;
+    /**
+     * @brief Register the deadline, then give the value to the waiting reader or push to the channel
+     * @return false  Timed out without suspension
+     * @see channel_writer::await_suspend
+     */
+    bool await_suspend(coroutine_handle<void> coro) noexcept(false) {
+        timers.insert(this);
+        owner.mtx.lock();
+        if (this->handoff(owner, coro))
+            return true; // don't access the members. the writer can be resumed already
+        if (this->state == expired || this->deadline <= clock_type::now()) {
+            owner.mtx.unlock();
+            status = channel_status::timed_out;
+            return false;
+        }
+        this->state = parked;
+        this->park(owner, coro);
+        return true;
+    }
+    /**
+     * @return channel_status
+     */
+    channel_status await_resume() noexcept(false) {
+        timers.erase(this);
+        if (this->frame == internal::poison())
+            return channel_status::closed;
+        return status;
+    }
 };
 
 /**
@@ -484,6 +1205,7 @@ class channel_peeker final : protected channel_reader<T, M> {
         std::unique_lock lck{this->chan->mtx};
         if (this->chan->writer_list::is_empty() == false) {
             writer* w = this->chan->writer_list::pop();
+            this->chan->count_take(w, static_cast<const channel_reader<T, M>*>(this));
             std::swap(this->ptr, w->ptr);
             std::swap(this->frame, w->frame);
         }
@@ -512,7 +1234,7 @@ class channel_peeker final : protected channel_reader<T, M> {
         storage = std::move(*this->ptr);
         // resume writer coroutine
         if (auto coro = coro::coroutine_handle<void>::from_address(this->frame))
-            coro.resume();
+            internal::handoff_queue::current().post(coro);
         return true;
     }
 };
@@ -0,0 +1,481 @@
+/**
+ * @file coroutine/channel_broadcast.hpp
+ * @author github.com/luncliff (luncliff@gmail.com)
+ * @copyright CC BY 4.0
+ *
+ * @brief Channel which delivers each value to all of its subscribers
+ */
+#pragma once
+#ifndef LUNCLIFF_COROUTINE_CHANNEL_BROADCAST_HPP
+#define LUNCLIFF_COROUTINE_CHANNEL_BROADCAST_HPP
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+#include <coroutine/channel.hpp>
+
+namespace coro {
+
+/**
+ * @brief Behavior of `broadcast_channel` when its ring buffer is full
+ * @ingroup channel
+ */
+enum class broadcast_policy : uint32_t {
+    backpressure = 0, ///< The writer waits until the slowest subscriber reads the oldest value
+    drop_oldest = 1,  ///< The writer overwrites the oldest value. Lagging subscriber skips it and counts the lag
+};
+
+template <typename T, typename M = bypass_mutex>
+class broadcast_channel;
+template <typename T, typename M>
+class broadcast_subscriber;
+template <typename T, typename M>
+class broadcast_reader;
+template <typename T, typename M>
+class broadcast_writer;
+
+/**
+ * @brief Awaitable for `broadcast_channel`'s write operation.
+ *        The value is moved into the channel once, and shared by all subscribers.
+ *
+ * @code
+ * auto publish(broadcast_channel<config_t>& ch, config_t value) -> frame_t {
+ *     bool ok = co_await ch.write(value);
+ *     if(ok == false)
+ *         ; // channel is under destruction !!!
+ * }
+ * @endcode
+ *
+ * @tparam T type of the element
+ * @tparam M mutex for the channel
+ * @ingroup channel
+ */
+template <typename T, typename M>
+class broadcast_writer final {
+  public:
+    using value_type = T;
+    using pointer = T*;
+    using channel_type = broadcast_channel<T, M>;
+
+  private:
+    friend channel_type;
+    friend internal::list<broadcast_writer>;
+
+    channel_type& chan;
+    pointer ptr;                       /// Address of value
+    void* frame = nullptr;             /// Resumeable Handle
+    broadcast_writer* next = nullptr; /// Next writer in channel
+
+  private:
+    broadcast_writer(channel_type& ch, pointer pv) noexcept : chan{ch}, ptr{pv} {
+    }
+
+  public:
+    broadcast_writer(const broadcast_writer&) = delete;
+    broadcast_writer& operator=(const broadcast_writer&) = delete;
+    broadcast_writer(broadcast_writer&&) = delete;
+    broadcast_writer& operator=(broadcast_writer&&) = delete;
+    ~broadcast_writer() noexcept = default;
+
+  public:
+    /**
+     * @brief Lock the channel and push the value to its ring buffer
+     *
+     * @return true   The value is delivered. Waiting subscribers are posted to `internal::handoff_queue`
+     * @return false  The ring buffer is full (`broadcast_policy::backpressure`).
+     *                The channel will be **lock**ed for this case.
+     */
+    bool await_ready() noexcept(false) {
+        chan.mtx.lock();
+        if (chan.try_push(*ptr) == false)
+            // await_suspend will unlock in the case
+            return false;
+        typename channel_type::wakeup_t wakeup{};
+        wakeup.readers = chan.take_readers();
+        chan.mtx.unlock();
+        wakeup.post();
+        return true;
+    }
+    /**
+     * @brief Wait for the slowest subscriber. It will push the value for this writer.
+     * @note  The channel will be **unlock**ed after return.
+     */
+    void await_suspend(coroutine_handle<void> coro) noexcept(false) {
+        this->frame = coro.address();
+        this->next = nullptr;
+        chan.park(this);
+        chan.mtx.unlock();
+    }
+    /**
+     * @return true   The value is delivered
+     * @return false  The `channel` is under destruction
+     */
+    bool await_resume() const noexcept {
+        return this->frame != internal::poison();
+    }
+};
+
+/**
+ * @brief Awaitable for `broadcast_subscriber`'s read operation.
+ *        Returns the shared value, which is same object for the other subscribers.
+ *
+ * @tparam T type of the element
+ * @tparam M mutex for the channel
+ * @ingroup channel
+ */
+template <typename T, typename M>
+class broadcast_reader final {
+  public:
+    using value_type = T;
+    using shared_type = std::shared_ptr<const T>;
+    using channel_type = broadcast_channel<T, M>;
+    using subscriber_type = broadcast_subscriber<T, M>;
+
+  private:
+    friend channel_type;
+    friend internal::list<broadcast_reader>;
+
+    subscriber_type& sub;
+    shared_type value{};
+    void* frame = nullptr;             /// Resumeable Handle
+    broadcast_reader* next = nullptr; /// Next reader in channel
+
+  private:
+    explicit broadcast_reader(subscriber_type& s) noexcept : sub{s} {
+    }
+    friend subscriber_type;
+
+  public:
+    broadcast_reader(const broadcast_reader&) = delete;
+    broadcast_reader& operator=(const broadcast_reader&) = delete;
+    broadcast_reader(broadcast_reader&&) = delete;
+    broadcast_reader& operator=(broadcast_reader&&) = delete;
+    ~broadcast_reader() noexcept = default;
+
+  public:
+    /**
+     * @brief Lock the channel and take the value at the subscriber's cursor
+     *
+     * @return true   Took the value
+     * @return false  There was no new value.
+     *                The channel will be **lock**ed for this case.
+     */
+    bool await_ready() noexcept(false) {
+        channel_type& chan = sub.chan;
+        chan.mtx.lock();
+        if (chan.readable(sub) == false)
+            // await_suspend will unlock in the case
+            return false;
+        value = chan.take(sub);
+        auto wakeup = chan.resume_writers();
+        chan.mtx.unlock();
+        wakeup.post();
+        return true;
+    }
+    /**
+     * @brief Wait for the next write
+     * @note  The channel will be **unlock**ed after return.
+     */
+    void await_suspend(coroutine_handle<void> coro) noexcept(false) {
+        channel_type& chan = sub.chan;
+        this->frame = coro.address();
+        this->next = nullptr;
+        chan.park(this);
+        chan.mtx.unlock();
+    }
+    /**
+     * @brief Returns the shared value, and `bool` indicator for the associtated channel's destruction
+     * @return tuple<shared_ptr<const value_type>, bool>
+     */
+    auto await_resume() noexcept(false) -> std::tuple<shared_type, bool> {
+        if (this->frame == internal::poison())
+            return std::make_tuple(nullptr, false);
+        if (value == nullptr) { // resumed by writer. take the value now
+            channel_type& chan = sub.chan;
+            chan.mtx.lock();
+            value = chan.take(sub);
+            auto wakeup = chan.resume_writers();
+            chan.mtx.unlock();
+            wakeup.post();
+        }
+        return std::make_tuple(std::move(value), true);
+    }
+};
+
+/**
+ * @brief Subscription to `broadcast_channel`. Holds its own cursor over the channel's ring buffer.
+ * @note  The subscriber receives the values written after its construction.
+ *        It must be destroyed before the channel.
+ *
+ * @code
+ * auto listen(broadcast_channel<config_t>& ch) -> frame_t {
+ *     broadcast_subscriber sub{ch};
+ *     while(true) {
+ *         auto [config, ok] = co_await sub.read();
+ *         if(ok == false)
+ *             co_return; // channel is under destruction !!!
+ *         apply(*config); // shared_ptr<const config_t>
+ *     }
+ * }
+ * @endcode
+ *
+ * @tparam T type of the element
+ * @tparam M mutex for the channel
+ * @ingroup channel
+ */
+template <typename T, typename M>
+class broadcast_subscriber final {
+  public:
+    using channel_type = broadcast_channel<T, M>;
+    using reader = broadcast_reader<T, M>;
+
+  private:
+    friend channel_type;
+    friend reader;
+
+    channel_type& chan;
+    uint64_t cursor;     /// sequence number of the next value
+    uint64_t lagged = 0; /// count of the values dropped before read
+
+  public:
+    explicit broadcast_subscriber(channel_type& ch) noexcept(false) : chan{ch}, cursor{} {
+        std::unique_lock lck{chan.mtx};
+        cursor = chan.subscribe();
+    }
+    /**
+     * @brief Release the values which are not read yet, so the writer won't wait for this subscriber
+     */
+    ~broadcast_subscriber() noexcept(false) {
+        chan.mtx.lock();
+        chan.unsubscribe(*this);
+        auto wakeup = chan.resume_writers();
+        chan.mtx.unlock();
+        wakeup.post();
+    }
+    broadcast_subscriber(const broadcast_subscriber&) = delete;
+    broadcast_subscriber& operator=(const broadcast_subscriber&) = delete;
+    broadcast_subscriber(broadcast_subscriber&&) = delete;
+    broadcast_subscriber& operator=(broadcast_subscriber&&) = delete;
+
+  public:
+    /**
+     * @brief Count of the values which were dropped before this subscriber reads them
+     * @see broadcast_policy::drop_oldest
+     */
+    uint64_t lag() const noexcept {
+        return lagged;
+    }
+    /**
+     * @brief construct a new reader for this subscription
+     * @return broadcast_reader
+     */
+    auto read() noexcept -> reader {
+        return reader{*this};
+    }
+};
+
+/**
+ * @brief Channel that delivers each value to every subscriber.
+ *
+ * @details Written values are stored once in a ring buffer as `shared_ptr<const T>`,
+ * with a count of subscribers which didn't read them yet.
+ * Each `broadcast_subscriber` has its own cursor(sequence number) over the ring.
+ * So one write costs O(1) regardless of the subscriber count. It only posts the waiting readers.
+ *
+ * When the ring is full and the oldest value is not read by all subscribers,
+ * the writer waits (`broadcast_policy::backpressure`) or overwrites it (`broadcast_policy::drop_oldest`).
+ *
+ * @tparam T type of the element
+ * @tparam M Type of the mutex(lockable) for its member
+ * @ingroup channel
+ */
+template <typename T, typename M>
+class broadcast_channel final : internal::list<broadcast_reader<T, M>>, internal::list<broadcast_writer<T, M>> {
+    static_assert(std::is_reference<T>::value == false, "reference type can't be channel's value_type.");
+
+  public:
+    using value_type = T;
+    using reference = value_type&;
+    using shared_type = std::shared_ptr<const T>;
+    using mutex_type = M;
+
+  private:
+    using reader = broadcast_reader<T, M>;
+    using reader_list = internal::list<reader>;
+    using writer = broadcast_writer<T, M>;
+    using writer_list = internal::list<writer>;
+    using subscriber = broadcast_subscriber<T, M>;
+
+    friend reader;
+    friend writer;
+    friend subscriber;
+
+    struct slot_t final {
+        shared_type value{};
+        size_t remaining = 0; /// subscribers which didn't read the value
+    };
+
+  private:
+    mutex_type mtx{};
+    const uint64_t capacity;
+    const broadcast_policy policy;
+    std::unique_ptr<slot_t[]> ring;
+    uint64_t head = 0; /// sequence number of the oldest value in the ring
+    uint64_t tail = 0; /// sequence number of the next value
+    size_t subscribers = 0;
+
+  private:
+    broadcast_channel(const broadcast_channel&) = delete;
+    broadcast_channel(broadcast_channel&&) = delete;
+    broadcast_channel& operator=(const broadcast_channel&) = delete;
+    broadcast_channel& operator=(broadcast_channel&&) = delete;
+
+    slot_t& slot_at(uint64_t seq) noexcept {
+        return ring[seq % capacity];
+    }
+
+    // the functions below require the lock
+
+    uint64_t subscribe() noexcept {
+        ++subscribers;
+        return tail;
+    }
+    void unsubscribe(subscriber& sub) noexcept {
+        for (uint64_t seq = std::max(sub.cursor, head); seq < tail; ++seq)
+            --slot_at(seq).remaining;
+        sub.cursor = tail;
+        --subscribers;
+    }
+    void park(reader* r) noexcept {
+        reader_list& readers = *this;
+        readers.push(r);
+    }
+    void park(writer* w) noexcept {
+        writer_list& writers = *this;
+        writers.push(w);
+    }
+    bool readable(const subscriber& sub) const noexcept {
+        return sub.cursor < tail;
+    }
+    auto take(subscriber& sub) noexcept -> shared_type {
+        if (sub.cursor < head) { // the values are dropped by the writer
+            sub.lagged += head - sub.cursor;
+            sub.cursor = head;
+        }
+        slot_t& slot = slot_at(sub.cursor++);
+        --slot.remaining;
+        return slot.value;
+    }
+    /**
+     * @return false The writer must wait for the slowest subscriber
+     */
+    bool try_push(reference ref) noexcept(false) {
+        while (tail - head == capacity) {
+            slot_t& oldest = slot_at(head);
+            if (oldest.remaining && policy == broadcast_policy::backpressure)
+                return false;
+            oldest = slot_t{}; // lagging subscribers will skip it
+            ++head;
+        }
+        slot_t& slot = slot_at(tail);
+        slot.value = std::make_shared<const T>(std::move(ref));
+        slot.remaining = subscribers;
+        ++tail;
+        return true;
+    }
+    /**
+     * @brief Coroutines to resume after unlock. Readers are posted before writers
+     */
+    struct wakeup_t final {
+        reader_list readers{};
+        writer_list writers{};
+
+        void post() noexcept(false) {
+            auto& queue = internal::handoff_queue::current();
+            while (readers.is_empty() == false)
+                queue.post(coroutine_handle<void>::from_address(readers.pop()->frame));
+            while (writers.is_empty() == false)
+                queue.post(coroutine_handle<void>::from_address(writers.pop()->frame));
+        }
+    };
+
+    auto take_readers() noexcept -> reader_list {
+        reader_list& waiting = *this;
+        reader_list readers = waiting;
+        waiting = reader_list{};
+        return readers;
+    }
+    /**
+     * @brief Push the values of waiting writers while the ring has a space
+     */
+    auto resume_writers() noexcept(false) -> wakeup_t {
+        wakeup_t wakeup{};
+        writer_list& waiting = *this;
+        while (waiting.is_empty() == false) {
+            writer* w = waiting.peek();
+            if (try_push(*w->ptr) == false)
+                break;
+            wakeup.writers.push(waiting.pop());
+        }
+        if (wakeup.writers.is_empty() == false)
+            wakeup.readers = take_readers();
+        return wakeup;
+    }
+
+  public:
+    /**
+     * @param capacity count of the values in the ring buffer. Must be larger than 0
+     * @param policy   behavior for the full ring buffer
+     * @throw std::invalid_argument `capacity` is 0
+     */
+    explicit broadcast_channel(uint64_t capacity, broadcast_policy policy = broadcast_policy::backpressure) noexcept(false)
+        : reader_list{}, writer_list{}, mtx{}, capacity{capacity}, policy{policy},
+          ring{std::make_unique<slot_t[]>(capacity)} {
+        if (capacity == 0)
+            throw std::invalid_argument{"broadcast_channel requires non-zero capacity"};
+    }
+    /**
+     * @brief Resume all waiting coroutine read/write operations with `false`
+     *
+     * @details The waiting coroutines are detached under the lock, and resumed after the unlock.
+     * The resumed coroutine may destroy its `broadcast_subscriber`, which locks the channel again.
+     * @see channel::~channel
+     */
+    ~broadcast_channel() noexcept(false) {
+        void* closing = internal::poison();
+        writer_list writers{};
+        reader_list readers{};
+        {
+            std::unique_lock lck{mtx};
+            std::swap(writers, static_cast<writer_list&>(*this));
+            std::swap(readers, static_cast<reader_list&>(*this));
+        }
+        while (writers.is_empty() == false) {
+            writer* w = writers.pop();
+            auto coro = coroutine_handle<void>::from_address(w->frame);
+            w->frame = closing;
+            coro.resume();
+        }
+        while (readers.is_empty() == false) {
+            reader* r = readers.pop();
+            auto coro = coroutine_handle<void>::from_address(r->frame);
+            r->frame = closing;
+            coro.resume();
+        }
+    }
+
+  public:
+    /**
+     * @brief construct a new writer which references this channel
+     * @param ref `T&` which holds a value to be `move`d into the channel
+     * @return broadcast_writer
+     */
+    auto write(reference ref) noexcept -> writer {
+        return writer{*this, std::addressof(ref)};
+    }
+};
+
+} // namespace coro
+
+#endif // LUNCLIFF_COROUTINE_CHANNEL_BROADCAST_HPP
@@ -0,0 +1,180 @@
+/**
+ * @file coroutine/channel_mutex.hpp
+ * @author github.com/luncliff (luncliff@gmail.com)
+ * @copyright CC BY 4.0
+ *
+ * @brief Lockables for the short critical sections of `channel`. Spin for a while, then park the thread
+ */
+#pragma once
+#ifndef LUNCLIFF_COROUTINE_CHANNEL_MUTEX_HPP
+#define LUNCLIFF_COROUTINE_CHANNEL_MUTEX_HPP
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace coro {
+namespace internal {
+
+/**
+ * @brief Hint to the CPU that the thread is spinning. (`pause` in x86, `yield` in ARM)
+ * @ingroup channel
+ */
+inline void cpu_relax() noexcept {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#elif defined(_M_ARM64) || defined(_M_ARM)
+    __yield();
+#endif
+}
+
+/**
+ * @brief Block the thread while the `word` holds `expected`. Spurious return is possible
+ * @note  Linux uses private futex. The others use `atomic::wait` if available, or yield the thread
+ * @ingroup channel
+ */
+inline void park_on(std::atomic<uint32_t>& word, uint32_t expected) noexcept {
+#if defined(__linux__)
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t));
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#elif defined(__cpp_lib_atomic_wait)
+    word.wait(expected, std::memory_order_relaxed);
+#else
+    if (word.load(std::memory_order_relaxed) == expected)
+        std::this_thread::yield();
+#endif
+}
+
+/**
+ * @brief Wake up the threads parked on the `word`
+ * @param count the number of threads to wake. `INT_MAX` for all
+ * @ingroup channel
+ */
+inline void unpark(std::atomic<uint32_t>& word, int count) noexcept {
+#if defined(__linux__)
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+#elif defined(__cpp_lib_atomic_wait)
+    if (count == 1)
+        word.notify_one();
+    else
+        word.notify_all();
+#else
+    (void)word, (void)count; // the waiters are yielding
+#endif
+}
+
+} // namespace internal
+
+/**
+ * @brief Lockable which spins with `pause` for a bounded count, then parks the thread in the kernel (futex)
+ *
+ * @details The critical sections of `channel` are a few pointer swaps.
+ * So the lock is usually released before the spin ends, and the contention doesn't cost a system call.
+ * The state is 0(unlocked), 1(locked), 2(locked and there may be parked threads).
+ * `unlock` makes the system call only when the state was 2.
+ *
+ * @code
+ * channel<int, adaptive_mutex> ch{};
+ * @endcode
+ *
+ * @note This lock is not fair. See `ticket_mutex` for FIFO acquisition
+ * @ingroup channel
+ */
+class adaptive_mutex final {
+    static constexpr uint32_t unlocked = 0, locked = 1, contended = 2;
+    static constexpr uint32_t spin_count = 128;
+
+    std::atomic<uint32_t> state{};
+
+  public:
+    adaptive_mutex() noexcept = default;
+    adaptive_mutex(const adaptive_mutex&) = delete;
+    adaptive_mutex& operator=(const adaptive_mutex&) = delete;
+
+    bool try_lock() noexcept {
+        uint32_t expected = unlocked;
+        return state.compare_exchange_strong(expected, locked, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+    void lock() noexcept {
+        for (uint32_t i = 0; i < spin_count; ++i) {
+            // read before the RMW not to steal the cache line from the owner
+            if (state.load(std::memory_order_relaxed) == unlocked && try_lock())
+                return;
+            internal::cpu_relax();
+        }
+        // from now on, we may have parked threads. the `unlock` must wake one of them
+        while (state.exchange(contended, std::memory_order_acquire) != unlocked)
+            internal::park_on(state, contended);
+    }
+    void unlock() noexcept {
+        if (state.exchange(unlocked, std::memory_order_release) == contended)
+            internal::unpark(state, 1);
+    }
+};
+
+/**
+ * @brief Fair(FIFO) variant of `adaptive_mutex`. The threads acquire the lock in the order of their tickets
+ *
+ * @details `next` is the ticket dispenser and `serving` is the ticket which owns the lock.
+ * After the bounded spin, the thread parks on `serving`. Since only the thread of the next ticket can proceed,
+ * `unlock` wakes all parked threads, and the others park again.
+ * Use this when the starvation of some threads is a problem, not for the throughput.
+ *
+ * @ingroup channel
+ */
+class ticket_mutex final {
+    static constexpr uint32_t spin_count = 128;
+
+    std::atomic<uint32_t> next{};
+    std::atomic<uint32_t> serving{};
+    std::atomic<uint32_t> parked{}; /// number of the parked threads. `unlock` skips the system call if 0
+
+  public:
+    ticket_mutex() noexcept = default;
+    ticket_mutex(const ticket_mutex&) = delete;
+    ticket_mutex& operator=(const ticket_mutex&) = delete;
+
+    bool try_lock() noexcept {
+        uint32_t current = serving.load(std::memory_order_relaxed);
+        uint32_t expected = current;
+        // take a ticket only when it will be served immediately
+        return next.compare_exchange_strong(expected, current + 1, std::memory_order_acquire,
+                                            std::memory_order_relaxed);
+    }
+    void lock() noexcept {
+        const uint32_t ticket = next.fetch_add(1, std::memory_order_relaxed);
+        for (uint32_t i = 0; i < spin_count; ++i) {
+            if (serving.load(std::memory_order_acquire) == ticket)
+                return;
+            internal::cpu_relax();
+        }
+        for (uint32_t current = serving.load(std::memory_order_acquire); current != ticket;
+             current = serving.load(std::memory_order_acquire)) {
+            parked.fetch_add(1, std::memory_order_seq_cst);
+            // `unlock` increases `serving` before it checks `parked`. compare again after the registration
+            if (serving.load(std::memory_order_seq_cst) == current)
+                internal::park_on(serving, current);
+            parked.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+    void unlock() noexcept {
+        serving.fetch_add(1, std::memory_order_seq_cst);
+        if (parked.load(std::memory_order_seq_cst) != 0)
+            internal::unpark(serving, INT_MAX);
+    }
+};
+
+} // namespace coro
+
+#endif // LUNCLIFF_COROUTINE_CHANNEL_MUTEX_HPP
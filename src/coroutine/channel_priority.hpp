@@ -0,0 +1,338 @@
+/**
+ * @file coroutine/channel_priority.hpp
+ * @author github.com/luncliff (luncliff@gmail.com)
+ * @copyright CC BY 4.0
+ *
+ * @brief Channel which delivers the value of the highest priority writer first
+ */
+#pragma once
+#ifndef LUNCLIFF_COROUTINE_CHANNEL_PRIORITY_HPP
+#define LUNCLIFF_COROUTINE_CHANNEL_PRIORITY_HPP
+#include <cstdint>
+
+#include <coroutine/channel.hpp>
+
+namespace coro {
+
+template <typename T, typename M = bypass_mutex, uint32_t L = 8>
+class priority_channel;
+template <typename T, typename M, uint32_t L>
+class priority_channel_reader;
+template <typename T, typename M, uint32_t L>
+class priority_channel_writer;
+
+/**
+ * @brief Awaitable for `priority_channel`'s read operation.
+ *        Receives the value of the highest priority writer. Readers are matched in FIFO order.
+ *
+ * @tparam T type of the element
+ * @tparam M mutex for the channel
+ * @tparam L count of priority levels
+ * @see channel_reader
+ * @ingroup channel
+ */
+template <typename T, typename M, uint32_t L>
+class priority_channel_reader final {
+  public:
+    using value_type = T;
+    using pointer = T*;
+    using channel_type = priority_channel<T, M, L>;
+
+  private:
+    using writer = priority_channel_writer<T, M, L>;
+    friend channel_type;
+    friend writer;
+    friend internal::list<priority_channel_reader>;
+
+    channel_type& chan;
+    pointer ptr = nullptr;                   /// Address of value
+    void* frame = nullptr;                   /// Resumeable Handle
+    priority_channel_reader* next = nullptr; /// Next reader in channel
+
+  private:
+    explicit priority_channel_reader(channel_type& ch) noexcept : chan{ch} {
+    }
+
+  public:
+    priority_channel_reader(const priority_channel_reader&) = delete;
+    priority_channel_reader& operator=(const priority_channel_reader&) = delete;
+    priority_channel_reader(priority_channel_reader&&) = delete;
+    priority_channel_reader& operator=(priority_channel_reader&&) = delete;
+    ~priority_channel_reader() noexcept = default;
+
+  public:
+    /**
+     * @brief Lock the channel and take the highest priority `priority_channel_writer`
+     *
+     * @return true   Matched with a writer
+     * @return false  There was no waiting writer.
+     *                The channel will be **lock**ed for this case.
+     */
+    bool await_ready() noexcept(false) {
+        chan.mtx.lock();
+        writer* w = chan.pop_writer();
+        if (w == nullptr)
+            // await_suspend will unlock in the case
+            return false;
+        this->ptr = w->ptr;
+        this->frame = w->frame;
+        w->frame = nullptr;
+        chan.mtx.unlock();
+        return true;
+    }
+    /**
+     * @brief Push to the channel and wait for `priority_channel_writer`.
+     * @note  The channel will be **unlock**ed after return.
+     */
+    void await_suspend(coroutine_handle<void> coro) noexcept(false) {
+        this->frame = coro.address();
+        this->next = nullptr;
+        chan.park(this);
+        chan.mtx.unlock();
+    }
+    /**
+     * @brief Returns value from writer coroutine, and `bool` indicator for the associtated channel's destruction
+     * @note  The writer coroutine is posted to `internal::handoff_queue` after the move
+     * @return tuple<value_type, bool>
+     */
+    auto await_resume() noexcept(false) -> std::tuple<value_type, bool> {
+        if (this->frame == internal::poison())
+            return std::make_tuple(value_type{}, false);
+        auto t = std::make_tuple(std::move(*ptr), true);
+        if (auto coro = coroutine_handle<void>::from_address(frame))
+            internal::handoff_queue::current().post(coro);
+        return t;
+    }
+};
+
+/**
+ * @brief Awaitable for `priority_channel`'s write operation.
+ *
+ * @code
+ * auto send_control(priority_channel<message_t>& ch, message_t msg) -> frame_t {
+ *     bool ok = co_await ch.write(msg, 7); // higher level is delivered first
+ *     if(ok == false)
+ *         ; // channel is under destruction !!!
+ * }
+ * @endcode
+ *
+ * @tparam T type of the element
+ * @tparam M mutex for the channel
+ * @tparam L count of priority levels
+ * @see channel_writer
+ * @ingroup channel
+ */
+template <typename T, typename M, uint32_t L>
+class priority_channel_writer final {
+  public:
+    using value_type = T;
+    using pointer = T*;
+    using channel_type = priority_channel<T, M, L>;
+
+  private:
+    using reader = priority_channel_reader<T, M, L>;
+    friend channel_type;
+    friend reader;
+    friend internal::list<priority_channel_writer>;
+
+    channel_type& chan;
+    pointer ptr;                             /// Address of value
+    void* frame = nullptr;                   /// Resumeable Handle
+    priority_channel_writer* next = nullptr; /// Next writer in the same level
+    uint32_t level;                          /// Priority level. Can be promoted by aging
+
+  private:
+    priority_channel_writer(channel_type& ch, pointer pv, uint32_t lv) noexcept : chan{ch}, ptr{pv}, level{lv} {
+    }
+
+  public:
+    priority_channel_writer(const priority_channel_writer&) = delete;
+    priority_channel_writer& operator=(const priority_channel_writer&) = delete;
+    priority_channel_writer(priority_channel_writer&&) = delete;
+    priority_channel_writer& operator=(priority_channel_writer&&) = delete;
+    ~priority_channel_writer() noexcept = default;
+
+  public:
+    /**
+     * @brief The writer always suspends. The value must be moved by the reader before this writer continues.
+     */
+    constexpr bool await_ready() const noexcept {
+        return false;
+    }
+    /**
+     * @brief Give the value to the waiting reader, or wait in the bucket of its priority level
+     * @note  If matched, this coroutine may be resumed before the return of this function.
+     * @see channel_writer::await_suspend
+     */
+    void await_suspend(coroutine_handle<void> coro) noexcept(false) {
+        chan.mtx.lock();
+        if (reader* r = chan.pop_reader()) {
+            auto rh = coroutine_handle<void>::from_address(r->frame);
+            r->ptr = this->ptr;
+            r->frame = coro.address();
+            chan.mtx.unlock();
+            // don't access the members after this line. the writer can be resumed in the post
+            return internal::handoff_queue::current().post(rh);
+        }
+        this->frame = coro.address();
+        this->next = nullptr;
+        chan.park(this);
+        chan.mtx.unlock();
+    }
+    /**
+     * @return true   successfully sent the value to `priority_channel_reader`
+     * @return false  The `channel` is under destruction
+     */
+    bool await_resume() const noexcept {
+        return this->frame != internal::poison();
+    }
+};
+
+/**
+ * @brief `channel` variant which keeps the waiting writers in bucketed priority lists.
+ *        Readers always receive the value of the highest priority writer. FIFO in the same level.
+ *
+ * @details Each level is an `internal::list`, so there is no allocation for the waiting writers.
+ * If `aging` is not 0, the oldest writer of each level (except the top) is promoted one level
+ * after every `aging` deliveries. So a low priority writer can't starve under the load of higher levels.
+ *
+ * @tparam T type of the element
+ * @tparam M Type of the mutex(lockable) for its member
+ * @tparam L count of priority levels. `L - 1` is the highest
+ * @ingroup channel
+ */
+template <typename T, typename M, uint32_t L>
+class priority_channel final : internal::list<priority_channel_reader<T, M, L>> {
+    static_assert(std::is_reference<T>::value == false, "reference type can't be channel's value_type.");
+    static_assert(L > 0, "requires 1 or more priority levels");
+
+  public:
+    using value_type = T;
+    using reference = value_type&;
+    using mutex_type = M;
+
+  private:
+    using reader = priority_channel_reader<T, M, L>;
+    using reader_list = internal::list<reader>;
+    using writer = priority_channel_writer<T, M, L>;
+    using writer_list = internal::list<writer>;
+
+    friend reader;
+    friend writer;
+
+  private:
+    mutex_type mtx{};
+    writer_list levels[L]{};
+    const uint64_t aging;
+    uint64_t delivered = 0;
+
+  private:
+    priority_channel(const priority_channel&) = delete;
+    priority_channel(priority_channel&&) = delete;
+    priority_channel& operator=(const priority_channel&) = delete;
+    priority_channel& operator=(priority_channel&&) = delete;
+
+    // the functions below require the lock
+
+    void park(reader* r) noexcept {
+        reader_list& readers = *this;
+        readers.push(r);
+    }
+    void park(writer* w) noexcept {
+        levels[w->level].push(w);
+    }
+    auto pop_reader() noexcept -> reader* {
+        reader_list& readers = *this;
+        return readers.is_empty() ? nullptr : readers.pop();
+    }
+    /**
+     * @brief Promote the oldest writer of each level. Starts from the top to move a writer only once
+     */
+    void promote() noexcept {
+        for (uint32_t lv = L - 1; lv > 0; --lv) {
+            writer_list& lower = levels[lv - 1];
+            if (lower.is_empty())
+                continue;
+            writer* w = lower.pop();
+            w->level = lv;
+            levels[lv].push(w);
+        }
+    }
+    auto pop_writer() noexcept -> writer* {
+        for (uint32_t lv = L; lv > 0; --lv) {
+            writer_list& bucket = levels[lv - 1];
+            if (bucket.is_empty())
+                continue;
+            writer* w = bucket.pop();
+            if (aging && ++delivered % aging == 0)
+                promote();
+            return w;
+        }
+        return nullptr;
+    }
+
+  public:
+    /**
+     * @param aging promote waiting writers after every `aging` deliveries. 0 to disable
+     */
+    explicit priority_channel(uint64_t aging = 0) noexcept(false) : reader_list{}, mtx{}, aging{aging} {
+    }
+    /**
+     * @brief Resume all attached coroutine read/write operations with `false`
+     *
+     * @details The waiting coroutines are detached under the lock, and resumed after the unlock.
+     * So the resumed coroutine can lock the channel again.
+     * @see channel::~channel
+     */
+    ~priority_channel() noexcept(false) {
+        void* closing = internal::poison();
+        // once more for the operations which are started by the resumed coroutines
+        size_t repeat = 1;
+        do {
+            writer_list writers{};
+            reader_list readers{};
+            {
+                std::unique_lock lck{mtx};
+                for (writer_list& bucket : levels)
+                    while (bucket.is_empty() == false)
+                        writers.push(bucket.pop());
+                std::swap(readers, static_cast<reader_list&>(*this));
+            }
+            while (writers.is_empty() == false) {
+                writer* w = writers.pop();
+                auto coro = coroutine_handle<void>::from_address(w->frame);
+                w->frame = closing;
+                coro.resume();
+            }
+            while (readers.is_empty() == false) {
+                reader* r = readers.pop();
+                auto coro = coroutine_handle<void>::from_address(r->frame);
+                r->frame = closing;
+                coro.resume();
+            }
+        } while (repeat--);
+    }
+
+  public:
+    /**
+     * @brief construct a new writer which references this channel
+     *
+     * @param ref `T&` which holds a value to be `move`d to reader.
+     * @param level priority of the value. Clamped to `L - 1`
+     * @return priority_channel_writer
+     */
+    auto write(reference ref, uint32_t level = 0) noexcept -> writer {
+        return writer{*this, std::addressof(ref), level < L ? level : L - 1};
+    }
+    /**
+     * @brief construct a new reader which references this channel
+     * @return priority_channel_reader
+     */
+    auto read() noexcept -> reader {
+        return reader{*this};
+    }
+};
+
+} // namespace coro
+
+#endif // LUNCLIFF_COROUTINE_CHANNEL_PRIORITY_HPP
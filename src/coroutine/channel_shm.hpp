@@ -0,0 +1,367 @@
+/**
+ * @file coroutine/channel_shm.hpp
+ * @author github.com/luncliff (luncliff@gmail.com)
+ * @copyright CC BY 4.0
+ *
+ * @brief Channel between 2 processes. The ring buffer is in the shared memory and the wakeup is `eventfd` + epoll
+ */
+#pragma once
+#ifndef LUNCLIFF_COROUTINE_CHANNEL_SHM_HPP
+#define LUNCLIFF_COROUTINE_CHANNEL_SHM_HPP
+#if !(defined(__linux__))
+#error "expect Linux platform for this file"
+#endif
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+
+#include <coroutine/channel_spsc.hpp>
+#include <coroutine/linux.h>
+
+namespace coro {
+
+template <typename T, size_t N>
+class shm_channel;
+template <typename T, size_t N>
+class shm_channel_reader;
+template <typename T, size_t N>
+class shm_channel_writer;
+
+/**
+ * @brief Awaitable for `shm_channel`'s read operation. Copies an element out of the shared ring buffer.
+ *
+ * @tparam T type of the element
+ * @tparam N capacity of the ring buffer
+ * @see spsc_channel_reader
+ * @ingroup Linux
+ */
+template <typename T, size_t N>
+class shm_channel_reader final {
+  public:
+    using value_type = T;
+    using channel_type = shm_channel<T, N>;
+
+  private:
+    friend channel_type;
+
+    channel_type& chan;
+    uint64_t head;       /// `head` of the channel when this reader is created
+    bool parked = false; /// Suspended and waits for the `eventfd`
+
+  private:
+    explicit shm_channel_reader(channel_type& ch) noexcept : chan{ch}, head{} {
+    }
+
+  public:
+    shm_channel_reader(const shm_channel_reader&) = delete;
+    shm_channel_reader& operator=(const shm_channel_reader&) = delete;
+    shm_channel_reader(shm_channel_reader&&) = delete;
+    shm_channel_reader& operator=(shm_channel_reader&&) = delete;
+    ~shm_channel_reader() noexcept = default;
+
+  public:
+    bool await_ready() noexcept {
+        head = chan.shared->head.load(std::memory_order_relaxed); // consumer owns the `head`
+        return chan.readable(head);
+    }
+    /**
+     * @brief Park in the channel and register the `eventfd` to the `epoll_owner`
+     * @return false  Writer has pushed an element meanwhile. Continue
+     */
+    bool await_suspend(coroutine_handle<void> coro) noexcept(false) {
+        return parked = chan.park_reader(head, coro);
+    }
+    /**
+     * @note  The elements written before the close are still readable
+     * @return tuple<value_type, bool> `false` if the channel is empty and closed by any process
+     */
+    auto await_resume() noexcept(false) -> std::tuple<value_type, bool> {
+        if (parked)
+            chan.unpark(channel_type::reader_event);
+        if (chan.readable(head) == false) // resumed by the close
+            return std::make_tuple(value_type{}, false);
+        return std::make_tuple(chan.pop(head), true);
+    }
+};
+
+/**
+ * @brief Awaitable for `shm_channel`'s write operation. Copies the value into the shared ring buffer.
+ *
+ * @tparam T type of the element
+ * @tparam N capacity of the ring buffer
+ * @see spsc_channel_writer
+ * @ingroup Linux
+ */
+template <typename T, size_t N>
+class shm_channel_writer final {
+  public:
+    using value_type = T;
+    using channel_type = shm_channel<T, N>;
+
+  private:
+    friend channel_type;
+
+    channel_type& chan;
+    const value_type& ref;
+    uint64_t tail;       /// `tail` of the channel when this writer is created
+    bool parked = false; /// Suspended and waits for the `eventfd`
+
+  private:
+    shm_channel_writer(channel_type& ch, const value_type& value) noexcept : chan{ch}, ref{value}, tail{} {
+    }
+
+  public:
+    shm_channel_writer(const shm_channel_writer&) = delete;
+    shm_channel_writer& operator=(const shm_channel_writer&) = delete;
+    shm_channel_writer(shm_channel_writer&&) = delete;
+    shm_channel_writer& operator=(shm_channel_writer&&) = delete;
+    ~shm_channel_writer() noexcept = default;
+
+  public:
+    bool await_ready() noexcept {
+        tail = chan.shared->tail.load(std::memory_order_relaxed); // producer owns the `tail`
+        return chan.writable(tail);
+    }
+    /**
+     * @brief Park in the channel and register the `eventfd` to the `epoll_owner`
+     * @return false  Reader has popped an element meanwhile. Continue
+     */
+    bool await_suspend(coroutine_handle<void> coro) noexcept(false) {
+        return parked = chan.park_writer(tail, coro);
+    }
+    /**
+     * @return false  The channel is closed by any process
+     */
+    bool await_resume() noexcept(false) {
+        if (parked)
+            chan.unpark(channel_type::writer_event);
+        if (chan.shared->closed.load(std::memory_order_acquire))
+            return false;
+        chan.push(tail, ref);
+        return true;
+    }
+};
+
+/**
+ * @brief `spsc_channel` in a shared memory. 1 process writes, and the other process reads.
+ *        Use 2 channels for the duplex communication.
+ *
+ * @details The ring buffer and the `head`/`tail` with the parking flags are in `shm_segment`(memfd).
+ * The protocol is same with `spsc_channel`, but the parked peer is in the other process.
+ * So the peer is notified with its `eventfd`, and its `epoll_owner` resumes the coroutine.
+ * There is no system call while the ring buffer is neither empty nor full.
+ *
+ * @code
+ * // the first process
+ * epoll_owner ep{};
+ * shm_channel<message_t, 256> ch{ep};
+ * send_descriptors(sock, ch.fd(), ch.event_fd(0), ch.event_fd(1)); // SCM_RIGHTS
+ *
+ * // the second process
+ * epoll_owner ep{};
+ * shm_channel<message_t, 256> ch{ep, memfd, efd0, efd1};
+ * auto [msg, ok] = co_await ch.read();
+ * @endcode
+ *
+ * @note Each process must poll its `epoll_owner`, and resume the `epoll_event::data.ptr` like `wait_in`
+ *
+ * @tparam T type of the element. Must be trivially copyable since the addresses are different between processes
+ * @tparam N capacity of the ring buffer. Must be power of 2
+ * @ingroup Linux
+ */
+template <typename T, size_t N>
+class shm_channel final {
+    static_assert(std::is_trivially_copyable<T>::value, "the element is copied between the processes");
+    static_assert(N > 0 && (N & (N - 1)) == 0, "capacity must be power of 2");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "requires address-free atomic operations");
+
+  public:
+    using value_type = T;
+
+  private:
+    using reader = shm_channel_reader<T, N>;
+    using writer = shm_channel_writer<T, N>;
+    friend reader;
+    friend writer;
+
+    static constexpr uint32_t reader_event = 0, writer_event = 1; /// index of the `eventfd`
+    static constexpr uint64_t parked = 1;
+    static constexpr uint64_t step = 2;
+
+    /// @note The layout in the shared memory. No pointer
+    struct layout_t final {
+        alignas(internal::cache_line_size) std::atomic<uint64_t> head; /// written by consumer (+ parked writer flag)
+        alignas(internal::cache_line_size) std::atomic<uint64_t> tail; /// written by producer (+ parked reader flag)
+        alignas(internal::cache_line_size) std::atomic<uint32_t> closed;
+        alignas(internal::cache_line_size) T slots[N];
+    };
+
+  private:
+    shm_segment segment;
+    epoll_owner& ep;
+    layout_t* shared;
+    void* frames[2]{}; /// The coroutines of this process which are parked. Resumed in the destruction
+
+  private:
+    shm_channel(const shm_channel&) = delete;
+    shm_channel(shm_channel&&) = delete;
+    shm_channel& operator=(const shm_channel&) = delete;
+    shm_channel& operator=(shm_channel&&) = delete;
+
+    static constexpr uint64_t index_of(uint64_t position) noexcept {
+        return position / step;
+    }
+    T& slot_at(uint64_t position) noexcept {
+        return shared->slots[index_of(position) % N];
+    }
+    bool readable(uint64_t h) const noexcept {
+        return index_of(shared->tail.load(std::memory_order_acquire)) != index_of(h);
+    }
+    bool writable(uint64_t t) const noexcept {
+        return index_of(t) - index_of(shared->head.load(std::memory_order_acquire)) < N;
+    }
+
+    /**
+     * @brief Register the `eventfd` before the parking flag is visible to the other process.
+     *        If the peer signals between them, the `epoll_owner` reports it with the registration.
+     */
+    void subscribe(uint32_t index, coroutine_handle<void> coro) noexcept(false) {
+        epoll_event req{};
+        req.events = EPOLLET | EPOLLIN | EPOLLONESHOT;
+        req.data.ptr = coro.address();
+        frames[index] = coro.address();
+        ep.try_add(segment.event_fd(index), req);
+    }
+    bool park_reader(uint64_t h, coroutine_handle<void> coro) noexcept(false) {
+        if (shared->closed.load(std::memory_order_acquire))
+            return false;
+        subscribe(reader_event, coro);
+        uint64_t expected = h & ~parked;
+        if (shared->tail.compare_exchange_strong(expected, expected | parked, //
+                                                 std::memory_order_acq_rel, std::memory_order_acquire))
+            return true;
+        unsubscribe(reader_event); // the writer has pushed. no signal is coming
+        return false;
+    }
+    bool park_writer(uint64_t t, coroutine_handle<void> coro) noexcept(false) {
+        if (shared->closed.load(std::memory_order_acquire))
+            return false;
+        subscribe(writer_event, coro);
+        uint64_t expected = (t & ~parked) - N * step;
+        if (shared->head.compare_exchange_strong(expected, expected | parked, //
+                                                 std::memory_order_acq_rel, std::memory_order_acquire))
+            return true;
+        unsubscribe(writer_event);
+        return false;
+    }
+    /**
+     * @brief Disarm the registration which won't be signaled
+     */
+    void unsubscribe(uint32_t index) noexcept(false) {
+        frames[index] = nullptr;
+        epoll_event req{}; // the next `subscribe` modifies it
+        ep.try_add(segment.event_fd(index), req);
+    }
+    /**
+     * @brief Reset the `eventfd` after the wakeup. `EPOLLONESHOT` has disarmed the registration already
+     */
+    void unpark(uint32_t index) noexcept(false) {
+        frames[index] = nullptr;
+        segment.consume(index);
+    }
+
+    void push(uint64_t t, const value_type& value) noexcept(false) {
+        slot_at(t) = value;
+        const uint64_t old = shared->tail.exchange((t & ~parked) + step, std::memory_order_acq_rel);
+        if (old & parked) // empty -> non-empty with parked reader
+            segment.notify(reader_event);
+    }
+    auto pop(uint64_t h) noexcept(false) -> value_type {
+        value_type value = slot_at(h);
+        const uint64_t old = shared->head.exchange((h & ~parked) + step, std::memory_order_acq_rel);
+        if (old & parked) // full -> not-full with parked writer
+            segment.notify(writer_event);
+        return value;
+    }
+
+  public:
+    /**
+     * @brief Create a new shared memory for the channel
+     * @param ep The reactor of this process. Resumes the parked coroutines
+     * @throw system_error
+     */
+    explicit shm_channel(epoll_owner& ep) noexcept(false)
+        : segment{sizeof(layout_t)}, ep{ep}, shared{new (segment.data()) layout_t{}} {
+    }
+    /**
+     * @brief Open the channel with the descriptors from the other process. Takes their ownership
+     * @param ep The reactor of this process. Resumes the parked coroutines
+     * @throw system_error
+     * @throw invalid_argument The memory is too small for the channel
+     */
+    shm_channel(epoll_owner& ep, int64_t memfd, int64_t efd0, int64_t efd1) noexcept(false)
+        : segment{memfd, efd0, efd1}, ep{ep}, shared{static_cast<layout_t*>(segment.data())} {
+        if (segment.size() < sizeof(layout_t))
+            throw std::invalid_argument{"shm_segment is smaller than the channel's layout"};
+    }
+    /**
+     * @brief Close the channel for both processes.
+     *        The parked coroutine of this process is resumed here, and the other process is notified
+     */
+    ~shm_channel() noexcept(false) {
+        shared->closed.store(true, std::memory_order_release);
+        const uint64_t t = shared->tail.fetch_and(~parked, std::memory_order_acq_rel);
+        const uint64_t h = shared->head.fetch_and(~parked, std::memory_order_acq_rel);
+        if (t & parked) {
+            if (frames[reader_event])
+                coroutine_handle<void>::from_address(frames[reader_event]).resume();
+            else
+                segment.notify(reader_event);
+        }
+        if (h & parked) {
+            if (frames[writer_event])
+                coroutine_handle<void>::from_address(frames[writer_event]).resume();
+            else
+                segment.notify(writer_event);
+        }
+        for (uint32_t index : {reader_event, writer_event})
+            try {
+                ep.remove(segment.event_fd(index));
+            } catch (const std::system_error&) {
+                // the descriptor was never registered
+            }
+    }
+
+  public:
+    /** @return int64_t `memfd` of the shared memory */
+    int64_t fd() const noexcept {
+        return segment.fd();
+    }
+    /** @return int64_t `eventfd` for the reader(0) and the writer(1) */
+    int64_t event_fd(uint32_t index) const noexcept {
+        return segment.event_fd(index);
+    }
+
+    /**
+     * @brief construct a new writer which references this channel
+     * @param ref The value to be copied into the shared memory
+     * @return shm_channel_writer
+     */
+    auto write(const value_type& ref) noexcept -> writer {
+        return writer{*this, ref};
+    }
+    /**
+     * @brief construct a new reader which references this channel
+     * @return shm_channel_reader
+     */
+    auto read() noexcept -> reader {
+        return reader{*this};
+    }
+};
+
+} // namespace coro
+
+#endif // LUNCLIFF_COROUTINE_CHANNEL_SHM_HPP
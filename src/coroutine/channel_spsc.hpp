@@ -0,0 +1,316 @@
+/**
+ * @file coroutine/channel_spsc.hpp
+ * @author github.com/luncliff (luncliff@gmail.com)
+ * @copyright CC BY 4.0
+ *
+ * @brief Bounded channel for exactly 1 producer coroutine and 1 consumer coroutine
+ */
+#pragma once
+#ifndef LUNCLIFF_COROUTINE_CHANNEL_SPSC_HPP
+#define LUNCLIFF_COROUTINE_CHANNEL_SPSC_HPP
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include <coroutine/channel.hpp>
+
+namespace coro {
+
+template <typename T, size_t N>
+class spsc_channel;
+template <typename T, size_t N>
+class spsc_channel_reader;
+template <typename T, size_t N>
+class spsc_channel_writer;
+
+namespace internal {
+
+/**
+ * @brief Expected size of the cache line. Used to separate producer/consumer's memory
+ * @note  `std::hardware_destructive_interference_size` is not stable over compilers(ABI warning)
+ * @ingroup channel
+ */
+static constexpr size_t cache_line_size = 64;
+
+} // namespace internal
+
+/**
+ * @brief Awaitable for `spsc_channel`'s read operation. Moves an element out of the ring buffer.
+ *
+ * @code
+ * auto consume(spsc_channel<int, 64>& ch) -> frame_t {
+ *     auto [value, ok] = co_await ch.read();
+ *     if(ok == false)
+ *         ; // channel is under destruction !!!
+ * }
+ * @endcode
+ *
+ * @tparam T type of the element
+ * @tparam N capacity of the ring buffer
+ * @see spsc_channel_writer
+ * @ingroup channel
+ */
+template <typename T, size_t N>
+class spsc_channel_reader final {
+  public:
+    using value_type = T;
+    using channel_type = spsc_channel<T, N>;
+
+  private:
+    friend channel_type;
+
+    channel_type& chan;
+    uint64_t head; /// `head` of the channel when this reader is created
+
+  private:
+    explicit spsc_channel_reader(channel_type& ch) noexcept : chan{ch}, head{} {
+    }
+
+  public:
+    spsc_channel_reader(const spsc_channel_reader&) = delete;
+    spsc_channel_reader& operator=(const spsc_channel_reader&) = delete;
+    spsc_channel_reader(spsc_channel_reader&&) = delete;
+    spsc_channel_reader& operator=(spsc_channel_reader&&) = delete;
+    ~spsc_channel_reader() noexcept = default;
+
+  public:
+    /**
+     * @return true   The ring buffer has an element
+     * @return false  The ring buffer is empty. Have to wait for the writer
+     */
+    bool await_ready() noexcept {
+        head = chan.head.load(std::memory_order_relaxed); // consumer owns the `head`
+        return chan.readable(head);
+    }
+    /**
+     * @brief Park in the channel if it is still empty
+     * @return true   Suspended. The writer will resume this coroutine
+     * @return false  Writer has pushed an element meanwhile. Continue
+     */
+    bool await_suspend(coroutine_handle<void> coro) noexcept {
+        return chan.park_reader(head, coro);
+    }
+    /**
+     * @brief Returns the element and `bool` indicator for the associtated channel's destruction
+     * @return tuple<value_type, bool>
+     */
+    auto await_resume() noexcept(false) -> std::tuple<value_type, bool> {
+        auto t = std::make_tuple(value_type{}, false);
+        if (chan.closed.load(std::memory_order_acquire))
+            return t;
+        std::get<0>(t) = chan.pop(head);
+        std::get<1>(t) = true;
+        return t;
+    }
+};
+
+/**
+ * @brief Awaitable for `spsc_channel`'s write operation. Moves the value into the ring buffer.
+ *
+ * @tparam T type of the element
+ * @tparam N capacity of the ring buffer
+ * @see spsc_channel_reader
+ * @ingroup channel
+ */
+template <typename T, size_t N>
+class spsc_channel_writer final {
+  public:
+    using value_type = T;
+    using reference = T&;
+    using channel_type = spsc_channel<T, N>;
+
+  private:
+    friend channel_type;
+
+    channel_type& chan;
+    reference ref;
+    uint64_t tail; /// `tail` of the channel when this writer is created
+
+  private:
+    spsc_channel_writer(channel_type& ch, reference value) noexcept : chan{ch}, ref{value}, tail{} {
+    }
+
+  public:
+    spsc_channel_writer(const spsc_channel_writer&) = delete;
+    spsc_channel_writer& operator=(const spsc_channel_writer&) = delete;
+    spsc_channel_writer(spsc_channel_writer&&) = delete;
+    spsc_channel_writer& operator=(spsc_channel_writer&&) = delete;
+    ~spsc_channel_writer() noexcept = default;
+
+  public:
+    /**
+     * @return true   The ring buffer has a space for the value
+     * @return false  The ring buffer is full. Have to wait for the reader
+     */
+    bool await_ready() noexcept {
+        tail = chan.tail.load(std::memory_order_relaxed); // producer owns the `tail`
+        return chan.writable(tail);
+    }
+    /**
+     * @brief Park in the channel if it is still full
+     * @return true   Suspended. The reader will resume this coroutine
+     * @return false  Reader has popped an element meanwhile. Continue
+     */
+    bool await_suspend(coroutine_handle<void> coro) noexcept {
+        return chan.park_writer(tail, coro);
+    }
+    /**
+     * @return true   The value is moved into the channel
+     * @return false  The `channel` is under destruction
+     */
+    bool await_resume() noexcept(false) {
+        if (chan.closed.load(std::memory_order_acquire))
+            return false;
+        chan.push(tail, ref);
+        return true;
+    }
+};
+
+/**
+ * @brief Wait-free channel for 1 producer coroutine + 1 consumer coroutine. They can be on different threads.
+ *
+ * @details The `head`(consumer) and `tail`(producer) are on their own cache lines.
+ * Both of them are doubled index. The lowest bit is used as a parking flag of the other side.
+ *
+ * - The reader parks by CAS of `tail` from the observed (empty) value to `tail | 1`.
+ * - The writer publishes an element with `exchange` of `tail`, which clears the flag at once.
+ *   If the old value had the flag, it was the empty to non-empty transition with a parked reader.
+ *
+ * The same applies to `head` for the writer. Since the parking and the publishing are RMW to the same atomic object,
+ * acquire/release ordering is enough and no wakeup can be lost.
+ * The parked peer is resumed through `internal::handoff_queue` of the thread which made the transition.
+ *
+ * @note Using more than 1 producer or consumer is undefined behavior. Use `channel<T, std::mutex>` for the case.
+ *
+ * @tparam T type of the element
+ * @tparam N capacity of the ring buffer. Must be power of 2
+ * @ingroup channel
+ */
+template <typename T, size_t N>
+class spsc_channel final {
+    static_assert(std::is_reference<T>::value == false, "reference type can't be channel's value_type.");
+    static_assert(N > 0 && (N & (N - 1)) == 0, "capacity must be power of 2");
+
+  public:
+    using value_type = T;
+    using reference = value_type&;
+
+  private:
+    using reader = spsc_channel_reader<T, N>;
+    using writer = spsc_channel_writer<T, N>;
+    friend reader;
+    friend writer;
+
+    static constexpr uint64_t parked = 1;
+    static constexpr uint64_t step = 2;
+
+    /// @note slot for the element. Not constructed until `push`
+    struct slot_t final {
+        alignas(T) unsigned char bytes[sizeof(T)];
+    };
+
+  private:
+    alignas(internal::cache_line_size) std::atomic<uint64_t> head{}; /// written by consumer (+ parked writer flag)
+    void* writer_frame = nullptr;                                     /// the parked writer. guarded by `head`
+    alignas(internal::cache_line_size) std::atomic<uint64_t> tail{}; /// written by producer (+ parked reader flag)
+    void* reader_frame = nullptr;                                     /// the parked reader. guarded by `tail`
+    alignas(internal::cache_line_size) std::atomic_bool closed{};
+    alignas(internal::cache_line_size) slot_t slots[N];
+
+  private:
+    spsc_channel(const spsc_channel&) = delete;
+    spsc_channel(spsc_channel&&) = delete;
+    spsc_channel& operator=(const spsc_channel&) = delete;
+    spsc_channel& operator=(spsc_channel&&) = delete;
+
+    static constexpr uint64_t index_of(uint64_t position) noexcept {
+        return position / step;
+    }
+    T* slot_at(uint64_t position) noexcept {
+        return reinterpret_cast<T*>(slots[index_of(position) % N].bytes);
+    }
+
+    bool readable(uint64_t h) const noexcept {
+        return index_of(tail.load(std::memory_order_acquire)) != index_of(h);
+    }
+    bool writable(uint64_t t) const noexcept {
+        return index_of(t) - index_of(head.load(std::memory_order_acquire)) < N;
+    }
+
+    bool park_reader(uint64_t h, coroutine_handle<void> coro) noexcept {
+        reader_frame = coro.address();
+        if (closed.load(std::memory_order_acquire))
+            return false;
+        // tail must be same with the head(empty) and the flag must be cleared
+        uint64_t expected = h & ~parked;
+        return tail.compare_exchange_strong(expected, expected | parked, //
+                                            std::memory_order_acq_rel, std::memory_order_acquire);
+    }
+    bool park_writer(uint64_t t, coroutine_handle<void> coro) noexcept {
+        writer_frame = coro.address();
+        if (closed.load(std::memory_order_acquire))
+            return false;
+        // the head must be N element behind the tail(full)
+        uint64_t expected = (t & ~parked) - N * step;
+        return head.compare_exchange_strong(expected, expected | parked, //
+                                            std::memory_order_acq_rel, std::memory_order_acquire);
+    }
+
+    void push(uint64_t t, reference ref) noexcept(false) {
+        new (slot_at(t)) T{std::move(ref)};
+        const uint64_t old = tail.exchange((t & ~parked) + step, std::memory_order_acq_rel);
+        if (old & parked) // empty -> non-empty with parked reader
+            internal::handoff_queue::current().post(coroutine_handle<void>::from_address(reader_frame));
+    }
+    auto pop(uint64_t h) noexcept(false) -> value_type {
+        T* ptr = slot_at(h);
+        value_type value = std::move(*ptr);
+        ptr->~T();
+        const uint64_t old = head.exchange((h & ~parked) + step, std::memory_order_acq_rel);
+        if (old & parked) // full -> not-full with parked writer
+            internal::handoff_queue::current().post(coroutine_handle<void>::from_address(writer_frame));
+        return value;
+    }
+
+  public:
+    spsc_channel() noexcept = default;
+
+    /**
+     * @brief Resume the parked reader/writer and destroy remaining elements
+     * @note  Same with `channel`, user code must ensure there is no more read/write when the destruction starts
+     */
+    ~spsc_channel() noexcept(false) {
+        closed.store(true, std::memory_order_release);
+        // clear the flags. the resumed awaitable will see `closed` and return `false`
+        const uint64_t t = tail.fetch_and(~parked, std::memory_order_acq_rel);
+        const uint64_t h = head.fetch_and(~parked, std::memory_order_acq_rel);
+        if (t & parked)
+            coroutine_handle<void>::from_address(reader_frame).resume();
+        if (h & parked)
+            coroutine_handle<void>::from_address(writer_frame).resume();
+        for (uint64_t position = h & ~parked; index_of(position) != index_of(t); position += step)
+            slot_at(position)->~T();
+    }
+
+  public:
+    /**
+     * @brief construct a new writer which references this channel
+     * @param ref `T&` which holds a value to be `move`d into the channel
+     * @return spsc_channel_writer
+     */
+    auto write(reference ref) noexcept -> writer {
+        return writer{*this, ref};
+    }
+    /**
+     * @brief construct a new reader which references this channel
+     * @return spsc_channel_reader
+     */
+    auto read() noexcept -> reader {
+        return reader{*this};
+    }
+};
+
+} // namespace coro
+
+#endif // LUNCLIFF_COROUTINE_CHANNEL_SPSC_HPP
@@ -0,0 +1,267 @@
+/**
+ * @file coroutine/frame_allocator.hpp
+ * @author github.com/luncliff (luncliff@gmail.com)
+ * @copyright CC BY 4.0
+ *
+ * @brief Thread-local, size-class pool for the coroutine frames
+ */
+#pragma once
+#ifndef LUNCLIFF_COROUTINE_FRAME_ALLOCATOR_HPP
+#define LUNCLIFF_COROUTINE_FRAME_ALLOCATOR_HPP
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+namespace coro {
+
+/**
+ * @brief Counters of the current thread's frame heap
+ * @see pooled_frame::stats
+ * @ingroup Allocator
+ */
+struct frame_stats final {
+    static constexpr size_t class_count = 7; /// 64, 128, ... 4096 bytes
+
+    uint64_t sizes[class_count + 1]; /// allocations of each size class. the last one is for the large frames
+    uint64_t hits;                   /// served from the free list
+    uint64_t misses;                 /// `operator new` for a size class
+    uint64_t remote_frees;           /// frames destroyed in the other threads
+    uint64_t cached;                 /// blocks in the free lists now
+
+    double hit_rate() const noexcept {
+        const uint64_t total = hits + misses;
+        return total ? static_cast<double>(hits) / total : 0.0;
+    }
+};
+
+namespace internal {
+
+/**
+ * @brief Per-thread heap of the frames. The owner thread uses the free lists without any lock.
+ *        The other threads push the frames to the `remote` stack, and the owner takes all of them at once.
+ *
+ * @details When the owner thread exits, the `remote` stack is closed with a mark.
+ * After that, the other threads free the frames directly, and the last one deletes the heap.
+ * @ingroup Allocator
+ */
+class frame_heap final {
+  public:
+    static constexpr size_t min_shift = 6; // 64 bytes
+    static constexpr size_t class_count = frame_stats::class_count;
+    static constexpr size_t large = class_count;
+    static constexpr uint32_t cache_limit = 256; /// per size class
+
+    struct node_t final {
+        node_t* next;
+    };
+    /// @brief in front of the frame. keeps the frame aligned with `max_align_t`
+    struct alignas(std::max_align_t) header_t final {
+        frame_heap* owner;
+        uint32_t index; /// size class
+    };
+
+  private:
+    node_t* lists[class_count]{};
+    uint32_t counts[class_count]{};
+    std::atomic<node_t*> remote{};
+    std::atomic<uint64_t> refs{1}; /// live frames + the owner thread
+    frame_stats counters{};
+
+  private:
+    static node_t* closed() noexcept {
+        return reinterpret_cast<node_t*>(uintptr_t{1});
+    }
+    static header_t* header_of(node_t* node) noexcept {
+        return reinterpret_cast<header_t*>(node);
+    }
+
+    void release(uint64_t count) noexcept {
+        if (refs.fetch_sub(count, std::memory_order_acq_rel) == count)
+            delete this;
+    }
+    /// @brief move the remote frees to the free lists. owner only
+    void reclaim() noexcept {
+        node_t* node = remote.exchange(nullptr, std::memory_order_acquire);
+        uint64_t count = 0;
+        while (node) {
+            node_t* next = node->next;
+            cache(header_of(node)->index, node);
+            node = next;
+            ++count;
+        }
+        if (count)
+            release(count); // the owner holds a reference. can't be 0
+    }
+    void cache(uint32_t index, node_t* node) noexcept {
+        if (counts[index] >= cache_limit)
+            return ::operator delete(node);
+        node->next = lists[index];
+        lists[index] = node;
+        ++counts[index];
+    }
+
+  public:
+    static constexpr uint32_t index_of(size_t size) noexcept {
+        size_t block = size_t{1} << min_shift;
+        uint32_t index = 0;
+        while (block < size && index < class_count) {
+            block <<= 1;
+            ++index;
+        }
+        return index;
+    }
+
+    void* allocate(size_t size) noexcept(false) {
+        const size_t total = size + sizeof(header_t);
+        const uint32_t index = index_of(total);
+        ++counters.sizes[index];
+        void* block = nullptr;
+        if (index == large) {
+            block = ::operator new(total);
+        } else {
+            if (lists[index] == nullptr)
+                reclaim();
+            if (node_t* node = lists[index]) {
+                lists[index] = node->next;
+                --counts[index];
+                ++counters.hits;
+                block = node;
+            } else {
+                block = ::operator new(size_t{1} << (min_shift + index));
+                ++counters.misses;
+            }
+        }
+        refs.fetch_add(1, std::memory_order_relaxed);
+        auto* h = static_cast<header_t*>(block);
+        h->owner = this;
+        h->index = index;
+        return h + 1;
+    }
+
+    /// @brief for the thread without the heap. no owner
+    static void* allocate_unowned(size_t size) noexcept(false) {
+        auto* h = static_cast<header_t*>(::operator new(size + sizeof(header_t)));
+        h->owner = nullptr;
+        h->index = large;
+        return h + 1;
+    }
+
+    /// @param self the heap of the current thread. `nullptr` after its exit
+    static void deallocate(void* ptr, frame_heap* self) noexcept {
+        header_t* h = static_cast<header_t*>(ptr) - 1;
+        frame_heap* owner = h->owner;
+        if (owner == nullptr)
+            return ::operator delete(h);
+        if (h->index == large) {
+            ::operator delete(h);
+            return owner->release(1);
+        }
+        auto* node = reinterpret_cast<node_t*>(h);
+        if (owner == self) {
+            owner->cache(h->index, node);
+            return owner->release(1);
+        }
+        if (self)
+            ++self->counters.remote_frees;
+        node_t* head = owner->remote.load(std::memory_order_relaxed);
+        do {
+            if (head == closed()) { // the owner thread is gone
+                ::operator delete(node);
+                return owner->release(1);
+            }
+            node->next = head;
+        } while (owner->remote.compare_exchange_weak(head, node, std::memory_order_release,
+                                                     std::memory_order_relaxed) == false);
+    }
+
+    /// @brief the owner thread is exiting. free the cached blocks and close the `remote`
+    void abandon() noexcept {
+        node_t* node = remote.exchange(closed(), std::memory_order_acquire);
+        uint64_t count = 0;
+        for (; node; ++count) {
+            node_t* next = node->next;
+            ::operator delete(node);
+            node = next;
+        }
+        for (node_t*& list : lists)
+            while (list) {
+                node_t* next = list->next;
+                ::operator delete(list);
+                list = next;
+            }
+        release(count + 1);
+    }
+
+    frame_stats stats() const noexcept {
+        frame_stats result = counters;
+        result.cached = 0;
+        for (uint32_t c : counts)
+            result.cached += c;
+        return result;
+    }
+};
+
+/// @brief `nullptr` after the thread's exit
+inline frame_heap* current_frame_heap() noexcept {
+    thread_local frame_heap* heap = nullptr; // trivial. still accessible in the other thread_local's destruction
+    struct holder_t final {
+        holder_t() noexcept(false) {
+            heap = new frame_heap{};
+        }
+        ~holder_t() noexcept {
+            std::exchange(heap, nullptr)->abandon();
+        }
+    };
+    thread_local holder_t holder{};
+    return heap;
+}
+
+} // namespace internal
+
+/**
+ * @defgroup Allocator
+ * Allocation of the coroutine frames
+ */
+
+/**
+ * @brief Mixin for the promise types. The frames are from the thread-local free lists of the size classes.
+ *
+ * @details The frame sizes are rounded up to 64, 128, ... 4096 bytes. The larger ones use the global `operator new`.
+ * A frame destroyed in the other thread is returned to its owner thread with a lock-free stack.
+ * Each size class keeps at most 256 blocks. The cached blocks are freed when the thread exits.
+ *
+ * @code
+ * struct promise_type : promise_na, pooled_frame {
+ *     // ...
+ * };
+ * @endcode
+ *
+ * @note The promise bases of `coroutine/return.h` use the global `operator new`. The promise type opts in to this.
+ * @ingroup Allocator
+ */
+class pooled_frame {
+  public:
+    static void* operator new(size_t size) noexcept(false) {
+        internal::frame_heap* heap = internal::current_frame_heap();
+        if (heap == nullptr) // in the destruction of the thread_local objects
+            return internal::frame_heap::allocate_unowned(size);
+        return heap->allocate(size);
+    }
+    static void operator delete(void* ptr, size_t) noexcept {
+        internal::frame_heap::deallocate(ptr, internal::current_frame_heap());
+    }
+
+    /**
+     * @brief Counters of the current thread
+     */
+    static frame_stats stats() noexcept {
+        internal::frame_heap* heap = internal::current_frame_heap();
+        return heap ? heap->stats() : frame_stats{};
+    }
+};
+
+} // namespace coro
+
+#endif // LUNCLIFF_COROUTINE_FRAME_ALLOCATOR_HPP
@@ -0,0 +1,215 @@
+/**
+ * @file coroutine/frame_arena.hpp
+ * @author github.com/luncliff (luncliff@gmail.com)
+ * @copyright CC BY 4.0
+ *
+ * @brief Bump allocation of the coroutine frames. Release all frames of a request at once
+ */
+#pragma once
+#ifndef LUNCLIFF_COROUTINE_FRAME_ARENA_HPP
+#define LUNCLIFF_COROUTINE_FRAME_ARENA_HPP
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <coroutine/return.h>
+
+namespace coro {
+
+/**
+ * @brief Memory of the `frame_arena`'s chunks
+ * @see huge_page_source (Linux)
+ * @ingroup Allocator
+ */
+struct arena_source final {
+    using fn_acquire_t = void* (*)(void* context, size_t length);
+    using fn_release_t = void (*)(void* context, void* ptr, size_t length);
+
+  public:
+    void* context;
+    fn_acquire_t acquire; // throws if it fails
+    fn_release_t release;
+
+    /// @brief the global `operator new`
+    static arena_source heap() noexcept {
+        return arena_source{
+            nullptr, [](void*, size_t length) { return ::operator new(length); },
+            [](void*, void* ptr, size_t) { ::operator delete(ptr); }};
+    }
+};
+
+/**
+ * @brief Chunked bump allocator for the frames of a request.
+ *        `deallocate` does nothing but counting. The memory is released with `release` or the destructor
+ *
+ * It can also be used for the I/O buffers(`io_buffer_t`) of the request with `allocate`.
+ *
+ * @note The allocation is not thread-safe. Create the coroutines of an arena in one thread at a time.
+ *       The frames can be destroyed in any thread
+ * @see arena_frame
+ * @ingroup Allocator
+ */
+class frame_arena final {
+    static constexpr size_t alignment = alignof(std::max_align_t);
+
+    struct alignas(alignment) chunk_t final {
+        chunk_t* next;
+        size_t size; /// bytes after this header
+    };
+
+  private:
+    chunk_t* chunks = nullptr;
+    std::byte* cursor = nullptr;
+    std::byte* limit = nullptr;
+    const size_t chunk_size;
+    const arena_source source;
+    size_t used = 0;             /// bytes given to the frames
+    std::atomic<size_t> live{}; /// frames not destroyed yet
+
+  private:
+    static constexpr size_t align_up(size_t size) noexcept {
+        return (size + alignment - 1) & ~(alignment - 1);
+    }
+    void grow(size_t size) noexcept(false) {
+        const size_t length = size > chunk_size ? size : chunk_size;
+        auto* chunk = static_cast<chunk_t*>(source.acquire(source.context, sizeof(chunk_t) + length));
+        chunk->next = chunks;
+        chunk->size = length;
+        chunks = chunk;
+        cursor = reinterpret_cast<std::byte*>(chunk + 1);
+        limit = cursor + length;
+    }
+
+  public:
+    /**
+     * @param chunk_size bytes of each chunk(including its header). The larger frame uses its own chunk
+     * @param source where the chunks come from
+     */
+    explicit frame_arena(size_t chunk_size = 64 * 1024, arena_source source = arena_source::heap()) noexcept
+        : chunk_size{align_up(chunk_size > 2 * sizeof(chunk_t) ? chunk_size : 2 * sizeof(chunk_t)) - sizeof(chunk_t)},
+          source{source} {
+    }
+    ~frame_arena() noexcept {
+        release();
+    }
+    frame_arena(const frame_arena&) = delete;
+    frame_arena(frame_arena&&) = delete;
+    frame_arena& operator=(const frame_arena&) = delete;
+    frame_arena& operator=(frame_arena&&) = delete;
+
+    void* allocate(size_t size) noexcept(false) {
+        size = align_up(size);
+        if (static_cast<size_t>(limit - cursor) < size)
+            grow(size);
+        void* ptr = cursor;
+        cursor += size;
+        used += size;
+        live.fetch_add(1, std::memory_order_relaxed);
+        return ptr;
+    }
+    void deallocate(void*) noexcept {
+        live.fetch_sub(1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Free all chunks at once. The arena can be used again
+     * @note  All frames from this arena must be destroyed before this
+     */
+    void release() noexcept {
+        while (chunks) {
+            chunk_t* chunk = std::exchange(chunks, chunks->next);
+            source.release(source.context, chunk, sizeof(chunk_t) + chunk->size);
+        }
+        cursor = limit = nullptr;
+        used = 0;
+    }
+
+    /// @brief number of the frames which are not destroyed
+    size_t live_frames() const noexcept {
+        return live.load(std::memory_order_acquire);
+    }
+    /// @brief bytes given to the frames since the last `release`
+    size_t bytes_used() const noexcept {
+        return used;
+    }
+};
+
+namespace internal {
+
+template <typename T>
+constexpr bool is_arena_v = std::is_same_v<std::remove_cv_t<std::remove_reference_t<T>>, frame_arena>;
+
+/// @return the first `frame_arena&` in the arguments. `nullptr` if there is none
+inline frame_arena* find_arena() noexcept {
+    return nullptr;
+}
+template <typename T, typename... Args>
+frame_arena* find_arena(T& arg, Args&... args) noexcept {
+    if constexpr (is_arena_v<T>)
+        return std::addressof(arg);
+    else
+        return find_arena(args...);
+}
+
+} // namespace internal
+
+/**
+ * @brief Mixin for the promise types. If the coroutine has a `frame_arena&` parameter,
+ *        (e.g. `std::allocator_arg, arena, ...`) its frame is allocated from the arena.
+ *        The others use the global `operator new`.
+ *
+ * @code
+ * auto handle(std::allocator_arg_t, frame_arena& arena, request_t& req) -> task<void> {
+ *     // the children receive the same arena
+ *     auto body = co_await read_body(std::allocator_arg, arena, req);
+ *     // ...
+ * }
+ *
+ * frame_arena arena{};
+ * co_await handle(std::allocator_arg, arena, req);
+ * arena.release(); // after all frames of the request are destroyed
+ * @endcode
+ *
+ * @ingroup Allocator
+ */
+class arena_frame {
+    /// @brief in front of the frame. `nullptr` if the frame is not from an arena
+    struct alignas(std::max_align_t) header_t final {
+        frame_arena* arena;
+    };
+
+  private:
+    static void* fallback_new(size_t size) noexcept(false) {
+        return ::operator new(size);
+    }
+    static void fallback_delete(void* ptr, size_t size) noexcept {
+        ::operator delete(ptr, size);
+    }
+
+  public:
+    /**
+     * @brief The compiler gives the parameters of the coroutine function
+     */
+    template <typename... Args>
+    COROUTINE_FRAME_OPERATOR static void* operator new(size_t size, Args&... args) noexcept(false) {
+        frame_arena* arena = internal::find_arena(args...);
+        void* block = arena ? arena->allocate(size + sizeof(header_t)) : fallback_new(size + sizeof(header_t));
+        auto* h = static_cast<header_t*>(block);
+        h->arena = arena;
+        return h + 1;
+    }
+    COROUTINE_FRAME_OPERATOR static void operator delete(void* ptr, size_t size) noexcept {
+        header_t* h = static_cast<header_t*>(ptr) - 1;
+        if (h->arena)
+            return h->arena->deallocate(h);
+        fallback_delete(h, size + sizeof(header_t));
+    }
+};
+
+} // namespace coro
+
+#endif // LUNCLIFF_COROUTINE_FRAME_ARENA_HPP
@@ -0,0 +1,222 @@
+/**
+ * @file coroutine/frame_pool.hpp
+ * @author github.com/luncliff (luncliff@gmail.com)
+ * @copyright CC BY 4.0
+ *
+ * @brief Bounded, preallocated frames for the fire-and-forget coroutines
+ */
+#pragma once
+#ifndef LUNCLIFF_COROUTINE_FRAME_POOL_HPP
+#define LUNCLIFF_COROUTINE_FRAME_POOL_HPP
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#include <coroutine/return.h>
+
+namespace coro {
+
+/**
+ * @brief Fixed number of the frame blocks. Allocated once in the construction.
+ *        When all blocks are in use, the allocation fails instead of growing.
+ *
+ * @details The free blocks are in a lock-free stack of the indices. The head has a tag to avoid ABA.
+ * The frames can be destroyed in any thread.
+ *
+ * @see bounded_frame_t
+ * @ingroup Allocator
+ */
+class frame_pool final {
+  public:
+    static constexpr size_t alignment = alignof(std::max_align_t);
+    /// @brief Backpressure hook. Invoked in the failed allocation. (e.g. stop `accept` until the frames return)
+    using fn_exhausted_t = void (*)(void* context, frame_pool& pool) noexcept;
+
+  private:
+    static constexpr uint32_t none = UINT32_MAX;
+
+    const size_t block_size;
+    const uint32_t count;
+    std::unique_ptr<std::byte[]> blocks;
+    std::unique_ptr<std::atomic<uint32_t>[]> next; /// free list. outside of the blocks
+    std::atomic<uint64_t> head{};                  /// tag << 32 | index
+    std::atomic<uint32_t> used{};
+    std::atomic<uint64_t> rejects{};
+    fn_exhausted_t on_exhausted = nullptr;
+    void* context = nullptr;
+
+  private:
+    static constexpr size_t align_up(size_t size) noexcept {
+        return (size + alignment - 1) & ~(alignment - 1);
+    }
+    static constexpr uint64_t pack(uint64_t tag, uint32_t index) noexcept {
+        return tag << 32 | index;
+    }
+
+  public:
+    /**
+     * @param frame_size max size of the frames(including the header of `bounded_frame_t`). Give some margin
+     * @param count      number of the blocks. The upper bound of the live frames
+     * @throw std::bad_alloc
+     */
+    frame_pool(size_t frame_size, uint32_t count) noexcept(false)
+        : block_size{align_up(frame_size)}, count{count},
+          blocks{new std::byte[block_size * count]}, // aligned with `max_align_t`
+          next{new std::atomic<uint32_t>[count]} {
+        for (uint32_t i = 0; i < count; ++i)
+            next[i].store(i + 1 < count ? i + 1 : none, std::memory_order_relaxed);
+        head.store(pack(0, count ? 0 : none), std::memory_order_relaxed);
+    }
+    /// @note All frames from this pool must be destroyed before this
+    ~frame_pool() noexcept = default;
+    frame_pool(const frame_pool&) = delete;
+    frame_pool(frame_pool&&) = delete;
+    frame_pool& operator=(const frame_pool&) = delete;
+    frame_pool& operator=(frame_pool&&) = delete;
+
+    /// @brief Register the backpressure hook. Set it before the first allocation
+    void set_exhausted_hook(fn_exhausted_t fn, void* ctx = nullptr) noexcept {
+        on_exhausted = fn;
+        context = ctx;
+    }
+
+    /**
+     * @return `nullptr` if all blocks are in use or the `size` is larger than the block
+     */
+    void* allocate(size_t size) noexcept {
+        uint64_t h = head.load(std::memory_order_acquire);
+        while (size <= block_size) {
+            const auto index = static_cast<uint32_t>(h);
+            if (index == none)
+                break;
+            const uint64_t desired = pack((h >> 32) + 1, next[index].load(std::memory_order_relaxed));
+            if (head.compare_exchange_weak(h, desired, std::memory_order_acquire, std::memory_order_acquire)) {
+                used.fetch_add(1, std::memory_order_relaxed);
+                return blocks.get() + index * block_size;
+            }
+        }
+        rejects.fetch_add(1, std::memory_order_relaxed);
+        if (on_exhausted)
+            on_exhausted(context, *this);
+        return nullptr;
+    }
+    void deallocate(void* ptr) noexcept {
+        const auto index = static_cast<uint32_t>((static_cast<std::byte*>(ptr) - blocks.get()) / block_size);
+        used.fetch_sub(1, std::memory_order_relaxed);
+        uint64_t h = head.load(std::memory_order_relaxed);
+        do {
+            next[index].store(static_cast<uint32_t>(h), std::memory_order_relaxed);
+        } while (head.compare_exchange_weak(h, pack((h >> 32) + 1, index), std::memory_order_release,
+                                            std::memory_order_relaxed) == false);
+    }
+
+    /// @brief max size of the frame
+    size_t frame_size() const noexcept {
+        return block_size;
+    }
+    uint32_t capacity() const noexcept {
+        return count;
+    }
+    /// @brief number of the live frames
+    uint32_t size() const noexcept {
+        return used.load(std::memory_order_relaxed);
+    }
+    /// @brief number of the failed allocations
+    uint64_t rejected() const noexcept {
+        return rejects.load(std::memory_order_relaxed);
+    }
+};
+
+namespace internal {
+
+template <typename T>
+constexpr bool is_frame_pool_v = std::is_same_v<std::remove_cv_t<std::remove_reference_t<T>>, frame_pool>;
+
+/// @return the first `frame_pool&` in the arguments. `nullptr` if there is none
+inline frame_pool* find_frame_pool() noexcept {
+    return nullptr;
+}
+template <typename T, typename... Args>
+frame_pool* find_frame_pool(T& arg, Args&... args) noexcept {
+    if constexpr (is_frame_pool_v<T>)
+        return std::addressof(arg);
+    else
+        return find_frame_pool(args...);
+}
+
+} // namespace internal
+
+/**
+ * @brief Fire-and-forget return type. The frame is from the `frame_pool&` parameter of the coroutine.
+ *        If the pool is exhausted, the coroutine is not started and the returned object is `false`.
+ *
+ * @details Same with `null_frame_t`(no suspend in initial/final), but the frame returns to its pool when it ends.
+ * So the memory for the spawned handlers has a hard upper bound.
+ * The failure is reported with `get_return_object_on_allocation_failure`, not the exception.
+ * The coroutine without the `frame_pool&` parameter uses the global `operator new(nothrow)`.
+ *
+ * @code
+ * auto serve(frame_pool&, uint64_t sd) -> bounded_frame_t;
+ *
+ * frame_pool pool{1024, 10'000}; // 10k connections at most
+ * if (!serve(pool, sd)) // backpressure. reject the connection
+ *     close(sd);
+ * @endcode
+ *
+ * @see fire_and_forget
+ * @ingroup Return
+ */
+class bounded_frame_t final {
+    bool started = false;
+
+  public:
+    class promise_type final : public null_frame_promise {
+        /// @brief in front of the frame. `nullptr` if the frame is not from a pool
+        struct alignas(std::max_align_t) header_t final {
+            frame_pool* pool;
+        };
+
+      public:
+        template <typename... Args>
+        COROUTINE_FRAME_OPERATOR static void* operator new(size_t size, Args&... args) noexcept {
+            frame_pool* pool = internal::find_frame_pool(args...);
+            void* block = pool ? pool->allocate(size + sizeof(header_t))
+                               : ::operator new(size + sizeof(header_t), std::nothrow);
+            if (block == nullptr)
+                return nullptr;
+            auto* h = static_cast<header_t*>(block);
+            h->pool = pool;
+            return h + 1;
+        }
+        COROUTINE_FRAME_OPERATOR static void operator delete(void* ptr, size_t) noexcept {
+            header_t* h = static_cast<header_t*>(ptr) - 1;
+            if (h->pool)
+                return h->pool->deallocate(h);
+            ::operator delete(h);
+        }
+
+        bounded_frame_t get_return_object() noexcept {
+            return bounded_frame_t{true};
+        }
+        static bounded_frame_t get_return_object_on_allocation_failure() noexcept {
+            return bounded_frame_t{false};
+        }
+    };
+
+  private:
+    explicit bounded_frame_t(bool started) noexcept : started{started} {
+    }
+
+  public:
+    /// @return false  The pool was exhausted. The coroutine didn't start
+    explicit operator bool() const noexcept {
+        return started;
+    }
+};
+
+} // namespace coro
+
+#endif // LUNCLIFF_COROUTINE_FRAME_POOL_HPP
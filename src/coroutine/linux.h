@@ -8,8 +8,15 @@
 #if !(defined(__linux__))
 #error "expect Linux platform for this file"
 #endif
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <sched.h>
 #include <sys/epoll.h> // for Linux epoll
+#include <vector>
 
+#include <coroutine/frame_arena.hpp>
+#include <coroutine/pthread.h>
 #include <coroutine/return.h>
 #include <gsl/gsl>
 
@@ -140,6 +147,217 @@ class event final {
     void reset() noexcept(false);
 };
 
+/**
+ * @brief Shared memory(`memfd`) with 2 `eventfd` to notify the other process
+ * @ingroup Linux
+ *
+ * The descriptors are inherited with `fork`, or can be sent to the other process with `SCM_RIGHTS`.
+ * The other process opens the same memory with the received descriptors.
+ * Each object closes its descriptors in the destruction.
+ */
+class shm_segment final {
+    int64_t memfd;
+    int64_t efds[2];
+    void* addr;
+    size_t length;
+
+  private:
+    void release() noexcept;
+
+  public:
+    /**
+     * @brief Create a new `memfd` with the length and map it
+     * @throw system_error
+     */
+    explicit shm_segment(size_t length) noexcept(false);
+    /**
+     * @brief Map the memory of the descriptors from the other process. Takes their ownership
+     * @throw system_error
+     */
+    shm_segment(int64_t memfd, int64_t efd0, int64_t efd1) noexcept(false);
+    ~shm_segment() noexcept;
+    shm_segment(const shm_segment&) = delete;
+    shm_segment(shm_segment&&) = delete;
+    shm_segment& operator=(const shm_segment&) = delete;
+    shm_segment& operator=(shm_segment&&) = delete;
+
+    void* data() const noexcept;
+    size_t size() const noexcept;
+    int64_t fd() const noexcept;
+    int64_t event_fd(uint32_t index) const noexcept;
+    /**
+     * @brief Signal the `eventfd`. Its `epoll_owner` (of any process) will be notified
+     * @throw system_error
+     */
+    void notify(uint32_t index) noexcept(false);
+    /**
+     * @brief Reset the `eventfd`. It's not an error if the `eventfd` is not signaled
+     * @throw system_error
+     */
+    void consume(uint32_t index) noexcept(false);
+};
+
+/**
+ * @brief CPU topology of the system. Discovered from `/sys/devices/system`
+ * @ingroup Linux
+ *
+ * Place the related coroutines on the same core(SMT siblings), package(socket) or NUMA node
+ * to avoid the cross-socket cache traffic.
+ *
+ * @code
+ * const auto& topology = cpu_topology::current();
+ * co_await run_on_cpu(topology.of_core(sched_getcpu())); // stay near the current CPU
+ * @endcode
+ */
+class cpu_topology final {
+  public:
+    struct cpu_t final {
+        uint32_t id;
+        uint32_t core;    /// `core_id`. unique in the package
+        uint32_t package; /// `physical_package_id`. the socket
+        uint32_t node;    /// NUMA node. 0 if the system has no NUMA information
+    };
+
+  private:
+    std::vector<cpu_t> cpus{};
+    uint32_t node_count = 1;
+
+  public:
+    /**
+     * @param root the directory which has `cpu/` and `node/`
+     * @throw system_error `root/cpu/online` is not readable
+     */
+    explicit cpu_topology(const char* root = "/sys/devices/system") noexcept(false);
+
+    /**
+     * @brief The topology of this machine. Read once
+     */
+    static const cpu_topology& current() noexcept(false);
+
+    /// @brief the online CPUs. sorted by the id
+    gsl::span<const cpu_t> list() const noexcept;
+    /// @return `nullptr` if the CPU is offline
+    const cpu_t* find(uint32_t cpu) const noexcept;
+    uint32_t nodes() const noexcept;
+
+    cpu_set_t of_node(uint32_t node) const noexcept;
+    cpu_set_t of_package(uint32_t package) const noexcept;
+    /// @brief the SMT siblings of the CPU. includes the CPU itself
+    cpu_set_t of_core(uint32_t cpu) const noexcept;
+};
+
+/**
+ * @brief Resume the coroutine on a thread bound to the CPUs. The threads are reused with `pthread_pool`
+ * @see run_on_cpu
+ * @ingroup Linux
+ *
+ * With the realtime priority, the thread uses `SCHED_FIFO` and locks its stack in the memory before the first
+ * resume, so the page faults won't happen in the work. It requires `CAP_SYS_NICE`(or `RLIMIT_RTPRIO`).
+ */
+class continue_on_cpu final {
+    pthread_attr_t attr;
+    pthread_t tid{};
+
+  public:
+    /**
+     * @param realtime `SCHED_FIFO` priority. 0 for the normal scheduling
+     * @throw system_error
+     */
+    continue_on_cpu(const cpu_set_t& cpus, int realtime) noexcept(false);
+    ~continue_on_cpu() noexcept;
+    continue_on_cpu(const continue_on_cpu&) = delete;
+    continue_on_cpu(continue_on_cpu&&) = delete;
+    continue_on_cpu& operator=(const continue_on_cpu&) = delete;
+    continue_on_cpu& operator=(continue_on_cpu&&) = delete;
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+    /**
+     * @throw system_error `pthread_create` failed. `EPERM` for the realtime without the privilege
+     */
+    void await_suspend(coro::coroutine_handle<void> coro) noexcept(false);
+    void await_resume() noexcept {
+    }
+};
+
+/**
+ * @brief Continue on one of the given CPUs
+ * @code
+ * cpu_set_t cpus{};
+ * CPU_ZERO(&cpus);
+ * CPU_SET(3, &cpus);
+ * co_await run_on_cpu(cpus);
+ * assert(sched_getcpu() == 3);
+ * @endcode
+ * @param realtime `SCHED_FIFO` priority. 0 for the normal scheduling
+ * @ingroup Linux
+ */
+inline continue_on_cpu run_on_cpu(const cpu_set_t& cpus, int realtime = 0) noexcept(false) {
+    return continue_on_cpu{cpus, realtime};
+}
+
+/**
+ * @brief Continue on one of the CPUs in the NUMA node
+ * @throw invalid_argument the node has no online CPU
+ * @ingroup Linux
+ */
+continue_on_cpu run_on_numa_node(uint32_t node, int realtime = 0) noexcept(false);
+
+/**
+ * @brief `arena_source` of the 2MB huge pages. Reduces the TLB misses for the large number of frames/buffers
+ * @ingroup Linux
+ *
+ * @details Tries in the order, and falls back to the next one if it fails
+ *
+ * 1. `MAP_HUGETLB`. Requires the reserved pages(`/proc/sys/vm/nr_hugepages`)
+ * 2. `madvise(MADV_HUGEPAGE)` for the transparent huge pages. The kernel may use the small pages anyway
+ * 3. The small pages
+ *
+ * The lengths are rounded up to 2MB. Use the 2MB `chunk_size` for `frame_arena`.
+ *
+ * @code
+ * huge_page_source pages{};
+ * frame_arena arena{huge_page_source::page_size, pages.source()};
+ * @endcode
+ */
+class huge_page_source final {
+  public:
+    static constexpr size_t page_size = 2 << 20;
+
+    /// @brief the regions of each kind. mapped now
+    struct usage_t final {
+        size_t huge;    /// `MAP_HUGETLB` pages
+        size_t advised; /// `MADV_HUGEPAGE` regions in the huge page unit. The kernel may use the small pages anyway
+        size_t small;   /// fallback regions in the huge page unit
+    };
+
+  private:
+    std::mutex mtx{};
+    std::map<void*, uint32_t> regions{}; /// address -> kind. for the `usage`
+    size_t counters[3]{};
+    std::atomic<bool> use_hugetlb{true}; /// false after the first failure
+
+  public:
+    huge_page_source() noexcept = default;
+    huge_page_source(const huge_page_source&) = delete;
+    huge_page_source& operator=(const huge_page_source&) = delete;
+
+    /**
+     * @brief Map the pages. `length` is rounded up to `page_size`
+     * @throw system_error `mmap` failed
+     */
+    void* allocate(size_t length) noexcept(false);
+    /**
+     * @brief Unmap the region of `allocate`. Ignores the other pointers
+     */
+    void deallocate(void* ptr, size_t length) noexcept;
+
+    usage_t usage() noexcept(false);
+    /// @see frame_arena
+    arena_source source() noexcept;
+};
+
 /**
  * @brief Bind the given `event`(`eventfd`) to `epoll_owner`(Epoll)
  * 
@@ -149,7 +367,7 @@ class event final {
  * @return awaitable struct for the binding
  * @ingroup Linux
  */
-auto wait_in(epoll_owner& ep, event& efd) {
+inline auto wait_in(epoll_owner& ep, event& efd) {
     class awaiter : epoll_event {
         epoll_owner& ep;
         event& efd;
@@ -7,6 +7,11 @@
 #pragma once
 #ifndef COROUTINE_NET_IO_H
 #define COROUTINE_NET_IO_H
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
 #include <gsl/gsl>
 
 #include <coroutine/return.h>
@@ -321,6 +326,281 @@ auto send_stream(uint64_t sd, io_buffer_t buf, uint32_t flag,
 auto recv_stream(uint64_t sd, io_buffer_t buf, uint32_t flag,
                  io_work_t& work) noexcept(false) -> io_recv&;
 
+/**
+ * @brief Index and generation of a pooled `io_work_t`.
+ *        The generation changes on each release, so the old ticket can't access the reused slot
+ * @see io_work_pool
+ * @ingroup Network
+ */
+struct io_work_ticket final {
+    uint32_t index;
+    uint32_t generation;
+};
+
+/**
+ * @brief Slab pool of the `io_work_t`. Acquire at the submission, and release at the completion.
+ *        So the memory for the operations follows the in-flight operations, not the open connections
+ *
+ * @details The slots are allocated by the slab(`slab_size` slots) and never moved/freed until the destruction.
+ * The completion from the system carries the `token` of the ticket.
+ * If the slot was released(e.g. the frame was destroyed while the operation is pending),
+ * the completion is stale and `resolve` returns `nullptr` instead of the next owner's coroutine.
+ *
+ * @note The slabs are stable. `at` doesn't lock, and the others use the mutex
+ * @see net_work_pool
+ * @ingroup Network
+ */
+class io_work_pool final {
+  public:
+    static constexpr uint32_t slab_size = 64;
+    static constexpr uint32_t max_slabs = 1024;
+
+  private:
+    struct slot_t final {
+        io_work_t work;
+        uint32_t generation;
+        uint32_t next; /// free list
+    };
+    static constexpr uint32_t none = UINT32_MAX;
+
+  private:
+    std::mutex mtx{};
+    std::atomic<slot_t*> slabs[max_slabs]{};
+    uint32_t slab_count = 0;
+    uint32_t free_head = none;
+    uint32_t in_flight = 0;
+    uint64_t stale = 0;
+
+  private:
+    slot_t& slot(uint32_t index) const noexcept {
+        return slabs[index / slab_size].load(std::memory_order_acquire)[index % slab_size];
+    }
+
+  public:
+    io_work_pool() noexcept = default;
+    ~io_work_pool() noexcept {
+        for (auto& slab : slabs)
+            delete[] slab.load(std::memory_order_relaxed);
+    }
+    io_work_pool(const io_work_pool&) = delete;
+    io_work_pool& operator=(const io_work_pool&) = delete;
+
+    /**
+     * @brief Take a free slot. Add a slab if there is none
+     * @throw std::bad_alloc  All `max_slabs` slabs are in use
+     */
+    io_work_ticket acquire() noexcept(false) {
+        std::lock_guard lck{mtx};
+        if (free_head == none) {
+            if (slab_count == max_slabs)
+                throw std::bad_alloc{};
+            auto* slab = new slot_t[slab_size]{};
+            const uint32_t base = slab_count * slab_size;
+            for (uint32_t i = 0; i < slab_size; ++i)
+                slab[i].next = i + 1 < slab_size ? base + i + 1 : none;
+            slabs[slab_count++].store(slab, std::memory_order_release);
+            free_head = base;
+        }
+        const uint32_t index = free_head;
+        slot_t& s = slot(index);
+        free_head = s.next;
+        ++in_flight;
+        s.work = io_work_t{};
+        return io_work_ticket{index, s.generation};
+    }
+    /// @note The stale ticket is ignored
+    void release(io_work_ticket ticket) noexcept {
+        std::lock_guard lck{mtx};
+        slot_t& s = slot(ticket.index);
+        if (s.generation != ticket.generation)
+            return;
+        ++s.generation;
+        s.next = std::exchange(free_head, ticket.index);
+        --in_flight;
+    }
+
+    /// @brief The slot of the ticket. The ticket must be acquired and not released
+    io_work_t& at(io_work_ticket ticket) const noexcept {
+        return slot(ticket.index).work;
+    }
+
+    /**
+     * @brief Find the waiting coroutine of the completion
+     * @return `nullptr` if the slot is already released. The stale completion is counted
+     */
+    coroutine_handle<void> resolve(io_work_ticket ticket) noexcept {
+        std::lock_guard lck{mtx};
+        if (ticket.index < slab_count * slab_size) {
+            slot_t& s = slot(ticket.index);
+            if (s.generation == ticket.generation)
+                return s.work.task;
+        }
+        ++stale;
+        return nullptr;
+    }
+
+    /// @brief The ticket in the 64 bit. The lowest bit is 1, so it can't be confused with the frame address
+    static uint64_t token(io_work_ticket ticket) noexcept {
+        return uint64_t{ticket.generation} << 32 | uint64_t{ticket.index} << 1 | 1u;
+    }
+    static bool is_token(uint64_t value) noexcept {
+        return value & 1u;
+    }
+    static io_work_ticket from_token(uint64_t token) noexcept {
+        return io_work_ticket{static_cast<uint32_t>(token) >> 1, static_cast<uint32_t>(token >> 32)};
+    }
+
+    /// @brief number of the acquired slots
+    size_t size() noexcept(false) {
+        std::lock_guard lck{mtx};
+        return in_flight;
+    }
+    size_t capacity() noexcept(false) {
+        std::lock_guard lck{mtx};
+        return size_t{slab_count} * slab_size;
+    }
+    /// @brief number of the completions for the released slots
+    uint64_t stale_count() noexcept(false) {
+        std::lock_guard lck{mtx};
+        return stale;
+    }
+};
+
+#if defined(__linux__)
+
+/**
+ * @brief The pool of the reactor(`poll_net_tasks`). The pooled operations use this
+ * @ingroup Network
+ */
+io_work_pool& net_work_pool() noexcept;
+
+namespace internal {
+
+/**
+ * @brief Register the pooled work to the reactor with its token
+ * @throw std::system_error
+ */
+void submit_pooled(io_work_ticket ticket, bool outbound) noexcept(false);
+
+} // namespace internal
+
+/**
+ * @brief Awaitable of the pooled `io_work_t`. Holds only the ticket, and releases the slot after the completion
+ * @tparam Op `io_send_to`, `io_recv_from`, `io_send`, `io_recv`
+ *
+ * @code
+ * auto op = recv_stream(sd, buf, 0); // no `io_work_t` in the frame
+ * int64_t sz = co_await op;
+ * if (auto ec = op.error())
+ *     // ...
+ * @endcode
+ *
+ * @ingroup Network
+ */
+template <typename Op>
+class io_pooled final {
+    static constexpr bool outbound = std::is_same_v<Op, io_send_to> || std::is_same_v<Op, io_send>;
+
+    io_work_pool* pool;
+    io_work_ticket ticket;
+    uint32_t errc = 0;
+
+  private:
+    Op& op() const noexcept {
+        return *reinterpret_cast<Op*>(std::addressof(pool->at(ticket)));
+    }
+
+  public:
+    io_pooled(io_work_pool& pool, io_work_ticket ticket) noexcept : pool{&pool}, ticket{ticket} {
+    }
+    /// @note If the operation is pending, its completion becomes stale
+    ~io_pooled() noexcept {
+        if (pool)
+            pool->release(ticket);
+    }
+    io_pooled(const io_pooled&) = delete;
+    io_pooled& operator=(const io_pooled&) = delete;
+    io_pooled(io_pooled&& rhs) noexcept
+        : pool{std::exchange(rhs.pool, nullptr)}, ticket{rhs.ticket}, errc{rhs.errc} {
+    }
+    io_pooled& operator=(io_pooled&&) = delete;
+
+  public:
+    bool await_ready() const noexcept {
+        return op().await_ready();
+    }
+    /**
+     * @throw std::system_error
+     */
+    void await_suspend(coro::coroutine_handle<void> t) noexcept(false) {
+        op().task = t;
+        internal::submit_pooled(ticket, outbound);
+    }
+    int64_t await_resume() noexcept {
+        const int64_t sz = op().await_resume();
+        errc = op().error();
+        std::exchange(pool, nullptr)->release(ticket);
+        return sz;
+    }
+
+    /// @return uint32_t error code of the completed operation
+    uint32_t error() const noexcept {
+        return errc;
+    }
+    /// @brief The slot of the ticket. Valid until the `await_resume`
+    io_work_t& work() const noexcept {
+        return pool->at(ticket);
+    }
+};
+
+/**
+ * @brief `send_to` with the `io_work_t` from `net_work_pool`
+ * @ingroup Network
+ */
+template <typename Address>
+auto send_to(uint64_t sd, const Address& remote, io_buffer_t buf) noexcept(false) -> io_pooled<io_send_to> {
+    io_work_pool& pool = net_work_pool();
+    io_pooled<io_send_to> op{pool, pool.acquire()}; // owns the slot before the call. releases it if the call throws
+    send_to(sd, remote, buf, op.work());
+    return op;
+}
+
+/**
+ * @brief `recv_from` with the `io_work_t` from `net_work_pool`
+ * @ingroup Network
+ */
+template <typename Address>
+auto recv_from(uint64_t sd, Address& remote, io_buffer_t buf) noexcept(false) -> io_pooled<io_recv_from> {
+    io_work_pool& pool = net_work_pool();
+    io_pooled<io_recv_from> op{pool, pool.acquire()};
+    recv_from(sd, remote, buf, op.work());
+    return op;
+}
+
+/**
+ * @brief `send_stream` with the `io_work_t` from `net_work_pool`
+ * @ingroup Network
+ */
+inline auto send_stream(uint64_t sd, io_buffer_t buf, uint32_t flag) noexcept(false) -> io_pooled<io_send> {
+    io_work_pool& pool = net_work_pool();
+    io_pooled<io_send> op{pool, pool.acquire()};
+    send_stream(sd, buf, flag, op.work());
+    return op;
+}
+
+/**
+ * @brief `recv_stream` with the `io_work_t` from `net_work_pool`
+ * @ingroup Network
+ */
+inline auto recv_stream(uint64_t sd, io_buffer_t buf, uint32_t flag) noexcept(false) -> io_pooled<io_recv> {
+    io_work_pool& pool = net_work_pool();
+    io_pooled<io_recv> op{pool, pool.acquire()};
+    recv_stream(sd, buf, flag, op.work());
+    return op;
+}
+
+#endif // __linux__
+
 /**
  * @brief Poll internal I/O works and invoke user callback
  * @param nano timeout in nanoseconds 
@@ -0,0 +1,216 @@
+/**
+ * @file coroutine/parallel.hpp
+ * @author github.com/luncliff (luncliff@gmail.com)
+ * @copyright CC BY 4.0
+ *
+ * @brief Consume the generator in the batches with `thread_pool`
+ */
+#pragma once
+#ifndef LUNCLIFF_COROUTINE_PARALLEL_HPP
+#define LUNCLIFF_COROUTINE_PARALLEL_HPP
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <coroutine/return.h>
+#include <coroutine/thread_pool.hpp>
+
+namespace coro {
+namespace internal {
+
+/**
+ * @brief Items of a batch and its output. Reused for the later batches
+ * @ingroup ThreadPool
+ */
+template <typename T, typename Out>
+struct parallel_batch final {
+    static constexpr uint32_t running = 0;
+    static constexpr uint32_t signaled = 1;
+    static constexpr uint32_t idle = 2; /// the worker doesn't access this anymore
+
+    std::vector<T> items{};
+    Out out{};
+    std::exception_ptr error{};
+    std::atomic<uint32_t> state{idle};
+
+    void wait() noexcept {
+        for (uint32_t s = state.load(std::memory_order_acquire); s != idle; s = state.load(std::memory_order_acquire)) {
+            if (s == running)
+                park_on(state, running);
+            else
+                std::this_thread::yield(); // between the `unpark` and the last store
+        }
+    }
+    void signal() noexcept {
+        state.store(signaled, std::memory_order_release);
+        unpark(state, 1);
+        state.store(idle, std::memory_order_release);
+    }
+};
+
+template <typename Batch, typename Work>
+auto run_batch(thread_pool& pool, Batch& batch, Work& work) -> null_frame_t {
+    co_await pool.schedule();
+    try {
+        work(batch);
+    } catch (...) {
+        batch.error = std::current_exception();
+    }
+    batch.signal();
+}
+
+template <typename R>
+using element_t = std::remove_cv_t<std::remove_reference_t<decltype(*std::declval<R&>().begin())>>;
+
+/**
+ * @brief Pull the batches in this thread, and process them in the pool.
+ *        At most `2 * pool.size()` batches are in flight. `emit` receives them in the source order
+ *
+ * @throw The first exception from the source, `work`, or `emit`. Thrown after all running batches end
+ * @ingroup ThreadPool
+ */
+template <typename Batch, typename R, typename Work, typename Emit>
+void run_partitioned(thread_pool& pool, R& source, size_t batch_size, Work& work, Emit& emit) noexcept(false) {
+    if (batch_size == 0)
+        batch_size = 1;
+    const size_t window = 2 * size_t{pool.size()};
+    auto slots = std::make_unique<Batch[]>(window);
+    size_t head = 0, tail = 0; // [head, tail) are in flight
+    std::exception_ptr error{};
+
+    auto finish_oldest = [&]() noexcept {
+        Batch& batch = slots[head++ % window];
+        batch.wait();
+        if (error)
+            return;
+        if (batch.error)
+            error = std::exchange(batch.error, nullptr);
+        else
+            try {
+                emit(batch);
+            } catch (...) {
+                error = std::current_exception();
+            }
+    };
+    try {
+        auto last = source.end();
+        for (auto it = source.begin(); it != last && error == nullptr;) {
+            if (tail - head == window)
+                finish_oldest();
+            Batch& batch = slots[tail % window];
+            batch.items.clear();
+            for (; it != last && batch.items.size() < batch_size; ++it)
+                batch.items.emplace_back(*it);
+            batch.state.store(Batch::running, std::memory_order_relaxed);
+            try {
+                run_batch(pool, batch, work);
+            } catch (...) { // failed to submit. nobody will signal
+                batch.state.store(Batch::idle, std::memory_order_relaxed);
+                throw;
+            }
+            ++tail;
+        }
+    } catch (...) {
+        if (error == nullptr)
+            error = std::current_exception();
+    }
+    while (head != tail)
+        finish_oldest();
+    if (error)
+        std::rethrow_exception(error);
+}
+
+} // namespace internal
+
+/**
+ * @brief Invoke `fn` for each element in the `thread_pool`. The elements are pulled in this thread
+ *
+ * @details `enumerable`(and the other generators) is resumed only by the calling thread.
+ * The elements are copied into the batches because the generator's reference is valid only until its next resume.
+ *
+ * @param fn `void(T&)`. Invoked concurrently. No order between the batches
+ * @param batch_size number of the elements in a batch
+ * @note Blocks the calling thread. Don't use it in the worker of the same `pool`
+ * @throw The first exception from the source or the `fn`
+ * @ingroup ThreadPool
+ */
+template <typename R, typename Fn>
+void parallel_for_each(thread_pool& pool, R&& source, Fn fn, size_t batch_size = 256) noexcept(false) {
+    using batch_t = internal::parallel_batch<internal::element_t<R>, std::nullptr_t>;
+    auto work = [&fn](batch_t& batch) {
+        for (auto& item : batch.items)
+            std::invoke(fn, item);
+    };
+    auto emit = [](batch_t&) noexcept {};
+    internal::run_partitioned<batch_t>(pool, source, batch_size, work, emit);
+}
+
+/**
+ * @brief Apply `fn` in the `thread_pool`, and deliver the results to `sink` in the source order
+ *
+ * @details The batches are reassembled in this thread. So `sink` is never invoked concurrently.
+ *
+ * @param fn   `U(T&)`. Invoked concurrently
+ * @param sink `void(U&&)`. Invoked in this thread
+ * @note Blocks the calling thread. Don't use it in the worker of the same `pool`
+ * @throw The first exception from the source, `fn`, or `sink`
+ * @ingroup ThreadPool
+ */
+template <typename R, typename Fn, typename Sink>
+void parallel_transform(thread_pool& pool, R&& source, Fn fn, Sink sink, size_t batch_size = 256) noexcept(false) {
+    using element_t = internal::element_t<R>;
+    using result_t = std::decay_t<std::invoke_result_t<Fn&, element_t&>>;
+    using batch_t = internal::parallel_batch<element_t, std::vector<result_t>>;
+    auto work = [&fn](batch_t& batch) {
+        batch.out.clear();
+        batch.out.reserve(batch.items.size());
+        for (auto& item : batch.items)
+            batch.out.emplace_back(std::invoke(fn, item));
+    };
+    auto emit = [&sink](batch_t& batch) {
+        for (auto& result : batch.out)
+            std::invoke(sink, std::move(result));
+    };
+    internal::run_partitioned<batch_t>(pool, source, batch_size, work, emit);
+}
+
+/**
+ * @brief Parallel version of `std::accumulate` over the generator
+ *
+ * @details Each batch is folded in the `thread_pool`, and the partial results are combined in the source order.
+ * Like `std::reduce`, `op` must be associative. (The order of the batches is kept, so it needn't be commutative)
+ *
+ * @param op `T(T, E)` and `T(T, T)` where `E` is the element type. Invoked concurrently
+ * @note Blocks the calling thread. Don't use it in the worker of the same `pool`
+ * @throw The first exception from the source or `op`
+ * @ingroup ThreadPool
+ */
+template <typename R, typename T, typename Op = std::plus<>>
+T parallel_reduce(thread_pool& pool, R&& source, T init, Op op = {}, size_t batch_size = 256) noexcept(false) {
+    using batch_t = internal::parallel_batch<internal::element_t<R>, std::optional<T>>;
+    auto work = [&op](batch_t& batch) {
+        auto it = batch.items.begin();
+        T partial = static_cast<T>(*it);
+        while (++it != batch.items.end())
+            partial = std::invoke(op, std::move(partial), *it);
+        batch.out.emplace(std::move(partial));
+    };
+    auto emit = [&op, &init](batch_t& batch) {
+        init = std::invoke(op, std::move(init), std::move(*batch.out));
+        batch.out.reset();
+    };
+    internal::run_partitioned<batch_t>(pool, source, batch_size, work, emit);
+    return init;
+}
+
+} // namespace coro
+
+#endif // LUNCLIFF_COROUTINE_PARALLEL_HPP
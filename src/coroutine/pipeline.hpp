@@ -0,0 +1,365 @@
+/**
+ * @file coroutine/pipeline.hpp
+ * @author github.com/luncliff (luncliff@gmail.com)
+ * @copyright CC BY 4.0
+ *
+ * @brief Lazy adaptors for `enumerable`. `| transform(f) | filter(p) | take(n) | zip(other)`
+ */
+#pragma once
+#ifndef LUNCLIFF_COROUTINE_PIPELINE_HPP
+#define LUNCLIFF_COROUTINE_PIPELINE_HPP
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace coro {
+
+/**
+ * @defgroup Pipeline
+ * Iterator wrappers over the generators. No coroutine frame for the stages
+ *
+ * @details Each stage is a view which wraps the iterator of its source. So the consumer loop resumes only
+ * the generator at the front, and the compiler can inline the stages into the loop body.
+ * The view owns the source if it is an rvalue(e.g. `enumerable` returned by the function),
+ * and refers to it if it is an lvalue.
+ *
+ * @code
+ * auto g = numbers(); // enumerable<int>
+ * for (auto [i, name] : g | filter(is_even) | transform(square) | take(10) | zip(names))
+ *     // ...
+ * @endcode
+ */
+
+namespace internal {
+
+template <typename R>
+using iterator_t = decltype(std::declval<R&>().begin());
+
+/// @brief The views keep the lvalue source by reference, and the rvalue one by value
+template <typename R>
+using stored_t = std::conditional_t<std::is_lvalue_reference_v<R>, R, std::remove_cv_t<std::remove_reference_t<R>>>;
+
+/// @brief Marker of the adaptor closure for `operator|`
+struct pipe_adaptor {};
+
+} // namespace internal
+
+/**
+ * @brief `f(*it)` for each element
+ * @ingroup Pipeline
+ */
+template <typename R, typename F>
+class transform_view final {
+    R source;
+    F fn;
+
+  public:
+    class iterator final {
+        friend class transform_view;
+
+        internal::iterator_t<R> it;
+        F* fn;
+
+        iterator(internal::iterator_t<R> it, F* fn) noexcept : it{std::move(it)}, fn{fn} {
+        }
+
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = ptrdiff_t;
+        using reference = std::invoke_result_t<F&, decltype(*it)>;
+        using value_type = std::remove_cv_t<std::remove_reference_t<reference>>;
+
+        iterator& operator++() noexcept(false) {
+            ++it;
+            return *this;
+        }
+        reference operator*() noexcept(false) {
+            return std::invoke(*fn, *it);
+        }
+        bool operator==(const iterator& rhs) const noexcept {
+            return it == rhs.it;
+        }
+        bool operator!=(const iterator& rhs) const noexcept {
+            return !(*this == rhs);
+        }
+    };
+
+  public:
+    transform_view(R&& source, F fn) noexcept(false) : source{std::forward<R>(source)}, fn{std::move(fn)} {
+    }
+
+    iterator begin() noexcept(false) {
+        return iterator{source.begin(), &fn};
+    }
+    iterator end() noexcept(false) {
+        return iterator{source.end(), &fn};
+    }
+};
+
+/**
+ * @brief Skip the elements which doesn't satisfy the predicate
+ * @ingroup Pipeline
+ */
+template <typename R, typename P>
+class filter_view final {
+    R source;
+    P pred;
+
+  public:
+    class iterator final {
+        friend class filter_view;
+
+        internal::iterator_t<R> it;
+        internal::iterator_t<R> last;
+        P* pred;
+
+        iterator(internal::iterator_t<R> it, internal::iterator_t<R> last, P* pred) noexcept(false)
+            : it{std::move(it)}, last{std::move(last)}, pred{pred} {
+            skip();
+        }
+        void skip() noexcept(false) {
+            while (it != last && std::invoke(*pred, *it) == false)
+                ++it;
+        }
+
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = ptrdiff_t;
+        using reference = decltype(*it);
+        using value_type = std::remove_cv_t<std::remove_reference_t<reference>>;
+
+        iterator& operator++() noexcept(false) {
+            ++it;
+            skip();
+            return *this;
+        }
+        reference operator*() noexcept(false) {
+            return *it;
+        }
+        bool operator==(const iterator& rhs) const noexcept {
+            return it == rhs.it;
+        }
+        bool operator!=(const iterator& rhs) const noexcept {
+            return !(*this == rhs);
+        }
+    };
+
+  public:
+    filter_view(R&& source, P pred) noexcept(false) : source{std::forward<R>(source)}, pred{std::move(pred)} {
+    }
+
+    /// @note The generator is resumed until the first match
+    iterator begin() noexcept(false) {
+        return iterator{source.begin(), source.end(), &pred};
+    }
+    iterator end() noexcept(false) {
+        return iterator{source.end(), source.end(), &pred};
+    }
+};
+
+/**
+ * @brief The first `count` elements. The generator is not resumed after the last one
+ * @ingroup Pipeline
+ */
+template <typename R>
+class take_view final {
+    R source;
+    size_t count;
+
+  public:
+    class iterator final {
+        friend class take_view;
+
+        internal::iterator_t<R> it;
+        internal::iterator_t<R> last;
+        size_t remain;
+
+        iterator(internal::iterator_t<R> it, internal::iterator_t<R> last, size_t remain) noexcept
+            : it{std::move(it)}, last{std::move(last)}, remain{remain} {
+        }
+        bool is_end() const noexcept {
+            return remain == 0 || it == last;
+        }
+
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = ptrdiff_t;
+        using reference = decltype(*it);
+        using value_type = std::remove_cv_t<std::remove_reference_t<reference>>;
+
+        iterator& operator++() noexcept(false) {
+            if (--remain) // don't resume for the element which won't be used
+                ++it;
+            return *this;
+        }
+        reference operator*() noexcept(false) {
+            return *it;
+        }
+        bool operator==(const iterator& rhs) const noexcept {
+            const bool lhs_end = is_end(), rhs_end = rhs.is_end();
+            if (lhs_end || rhs_end)
+                return lhs_end == rhs_end;
+            return it == rhs.it;
+        }
+        bool operator!=(const iterator& rhs) const noexcept {
+            return !(*this == rhs);
+        }
+    };
+
+  public:
+    take_view(R&& source, size_t count) noexcept(false) : source{std::forward<R>(source)}, count{count} {
+    }
+
+    /// @note The generator is resumed only if `count` is not 0
+    iterator begin() noexcept(false) {
+        if (count == 0)
+            return end();
+        return iterator{source.begin(), source.end(), count};
+    }
+    iterator end() noexcept(false) {
+        return iterator{source.end(), source.end(), 0};
+    }
+};
+
+/**
+ * @brief `std::pair` of the references from the 2 sources. Ends with the shorter one
+ * @ingroup Pipeline
+ */
+template <typename R1, typename R2>
+class zip_view final {
+    R1 first;
+    R2 second;
+
+  public:
+    class iterator final {
+        friend class zip_view;
+
+        internal::iterator_t<R1> it1, last1;
+        internal::iterator_t<R2> it2, last2;
+
+        iterator(internal::iterator_t<R1> it1, internal::iterator_t<R1> last1, //
+                 internal::iterator_t<R2> it2, internal::iterator_t<R2> last2) noexcept
+            : it1{std::move(it1)}, last1{std::move(last1)}, it2{std::move(it2)}, last2{std::move(last2)} {
+        }
+        bool is_end() const noexcept {
+            return it1 == last1 || it2 == last2;
+        }
+
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = ptrdiff_t;
+        using reference = std::pair<decltype(*it1), decltype(*it2)>;
+        using value_type = reference;
+
+        iterator& operator++() noexcept(false) {
+            ++it1;
+            ++it2;
+            return *this;
+        }
+        reference operator*() noexcept(false) {
+            return reference{*it1, *it2};
+        }
+        bool operator==(const iterator& rhs) const noexcept {
+            const bool lhs_end = is_end(), rhs_end = rhs.is_end();
+            if (lhs_end || rhs_end)
+                return lhs_end == rhs_end;
+            return it1 == rhs.it1 && it2 == rhs.it2;
+        }
+        bool operator!=(const iterator& rhs) const noexcept {
+            return !(*this == rhs);
+        }
+    };
+
+  public:
+    zip_view(R1&& first, R2&& second) noexcept(false)
+        : first{std::forward<R1>(first)}, second{std::forward<R2>(second)} {
+    }
+
+    iterator begin() noexcept(false) {
+        return iterator{first.begin(), first.end(), second.begin(), second.end()};
+    }
+    iterator end() noexcept(false) {
+        return iterator{first.end(), first.end(), second.end(), second.end()};
+    }
+};
+
+namespace internal {
+
+template <typename F>
+struct transform_adaptor final : pipe_adaptor {
+    F fn;
+
+    template <typename R>
+    auto operator()(R&& source) && noexcept(false) {
+        return transform_view<stored_t<R>, F>{std::forward<R>(source), std::move(fn)};
+    }
+};
+
+template <typename P>
+struct filter_adaptor final : pipe_adaptor {
+    P pred;
+
+    template <typename R>
+    auto operator()(R&& source) && noexcept(false) {
+        return filter_view<stored_t<R>, P>{std::forward<R>(source), std::move(pred)};
+    }
+};
+
+struct take_adaptor final : pipe_adaptor {
+    size_t count;
+
+    template <typename R>
+    auto operator()(R&& source) && noexcept(false) {
+        return take_view<stored_t<R>>{std::forward<R>(source), count};
+    }
+};
+
+template <typename R2>
+struct zip_adaptor final : pipe_adaptor {
+    R2 second;
+
+    template <typename R1>
+    auto operator()(R1&& first) && noexcept(false) {
+        return zip_view<stored_t<R1>, R2>{std::forward<R1>(first), std::forward<R2>(second)};
+    }
+};
+
+} // namespace internal
+
+/// @ingroup Pipeline
+template <typename F>
+auto transform(F fn) noexcept(std::is_nothrow_move_constructible_v<F>) {
+    return internal::transform_adaptor<F>{{}, std::move(fn)};
+}
+/// @ingroup Pipeline
+template <typename P>
+auto filter(P pred) noexcept(std::is_nothrow_move_constructible_v<P>) {
+    return internal::filter_adaptor<P>{{}, std::move(pred)};
+}
+/// @ingroup Pipeline
+inline auto take(size_t count) noexcept {
+    return internal::take_adaptor{{}, count};
+}
+/**
+ * @param second The lvalue is referred, and the rvalue is moved into the view
+ * @ingroup Pipeline
+ */
+template <typename R2>
+auto zip(R2&& second) noexcept(false) {
+    return internal::zip_adaptor<internal::stored_t<R2>>{{}, std::forward<R2>(second)};
+}
+
+/**
+ * @brief Apply the adaptor. `source | transform(f)` is `transform_view{source, f}`
+ * @ingroup Pipeline
+ */
+template <typename R, typename A, typename = std::enable_if_t<std::is_base_of_v<internal::pipe_adaptor, A>>>
+auto operator|(R&& source, A adaptor) noexcept(false) {
+    return std::move(adaptor)(std::forward<R>(source));
+}
+
+} // namespace coro
+
+#endif // LUNCLIFF_COROUTINE_PIPELINE_HPP
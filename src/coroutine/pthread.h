@@ -10,7 +10,10 @@
 #else
 #error "expect <pthread.h> for this file"
 #endif
+#include <atomic>
+#include <mutex>
 #include <system_error>
+#include <vector>
 
 #include <coroutine/return.h>
 
@@ -56,6 +59,106 @@ class continue_on_pthread final {
     }
 };
 
+/**
+ * @brief Parked POSIX Threads to be reused by `co_await pooled(attr)`
+ * @ingroup POSIX
+ *
+ * The threads are matched by the attributes (stack size, guard size, scheduling, CPU affinity).
+ * When the resume of the coroutine returns, the thread is parked again instead of its exit.
+ * If there are `limit` parked threads already, the thread exits.
+ * When a `spawn` finds no match in the full pool, the oldest parked thread exits instead.
+ * So the pool follows the attributes in recent use.
+ */
+class pthread_pool final {
+  public:
+    struct worker_t; // in pthread.cpp
+
+  private:
+    std::mutex mtx{};
+    std::vector<worker_t*> idle{};
+    const size_t limit;
+
+  private:
+    explicit pthread_pool(size_t limit) noexcept;
+
+  public:
+    /**
+     * @brief The pool is never destroyed. The parked threads end with the process
+     */
+    static pthread_pool& global() noexcept(false);
+
+    /**
+     * @brief Resume the coroutine on a parked thread with the same attributes, or create a new one
+     * @param completion Signaled after the resume returns. `nullptr` if nobody waits
+     * @return uint32_t error code of `pthread_create`
+     */
+    uint32_t spawn(pthread_t& tid, const pthread_attr_t* attr, coro::coroutine_handle<void> coro,
+                   std::atomic<uint32_t>* completion) noexcept(false);
+    /**
+     * @brief Signal the worker's `completion` and park it again
+     * @return false  The pool is full. The worker must exit
+     */
+    bool release(worker_t* w) noexcept(false);
+    size_t idle_count() noexcept(false);
+    /// @brief max number of the parked threads
+    size_t capacity() const noexcept {
+        return limit;
+    }
+
+    /**
+     * @brief Block until the `spawn`ed resume returns. Replaces `pthread_join` for the pooled thread
+     * @note  After the return, the pooled thread doesn't access the `completion`. It can be destroyed
+     */
+    static void wait(std::atomic<uint32_t>& completion) noexcept(false);
+};
+
+/**
+ * @brief Operand of `co_await` to continue on a thread of `pthread_pool`
+ * @see pooled
+ * @ingroup POSIX
+ */
+struct pthread_pooled final {
+    const pthread_attr_t* attr;
+};
+
+/**
+ * @brief Request a pooled thread instead of `pthread_create` for each `co_await`
+ * @code
+ * auto work(const pthread_attr_t* attr) -> pthread_joiner {
+ *     co_await pooled(attr); // reuse a parked thread if there is
+ * }
+ * @endcode
+ * @ingroup POSIX
+ */
+inline pthread_pooled pooled(const pthread_attr_t* attr) noexcept {
+    return pthread_pooled{attr};
+}
+
+/**
+ * @brief Resume the given coroutine handle on a thread of `pthread_pool`
+ * @ingroup POSIX
+ */
+class continue_on_pooled_pthread final {
+    pthread_t* const ptr;
+    const pthread_attr_t* const attr;
+    std::atomic<uint32_t>* const completion;
+
+  public:
+    continue_on_pooled_pthread(pthread_t& tid, const pthread_attr_t* attr, std::atomic<uint32_t>* completion)
+        : ptr{&tid}, attr{attr}, completion{completion} {
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+    void await_resume() noexcept {
+    }
+    void await_suspend(coro::coroutine_handle<void> coro) noexcept(false) {
+        if (int ec = pthread_pool::global().spawn(*ptr, attr, coro, completion))
+            throw std::system_error{ec, std::system_category(), "pthread_create"};
+    }
+};
+
 /**
  * @brief allows `pthread_attr_t*` for `co_await` operator 
  * @ingroup Thread
@@ -69,6 +172,9 @@ class continue_on_pthread final {
 class pthread_spawn_promise {
   public:
     pthread_t tid{};
+    bool pooled = false; /// `tid` is a thread of `pthread_pool`
+    /// @brief The return type's promise provides this if it waits for the pooled thread
+    std::atomic<uint32_t>* completion = nullptr;
 
   public:
     constexpr auto initial_suspend() noexcept {
@@ -94,6 +200,15 @@ class pthread_spawn_promise {
     inline auto await_transform(pthread_attr_t* attr) noexcept(false) {
         return await_transform(static_cast<const pthread_attr_t*>(attr));
     }
+    /**
+     * @brief co_await for `pooled(attr)`. Same with `pthread_attr_t*`, but the thread is reused
+     */
+    auto await_transform(pthread_pooled req) noexcept(false) {
+        if (tid) // already created.
+            throw std::logic_error{"pthread's spawn must be used once"};
+        pooled = true;
+        return continue_on_pooled_pthread{tid, req.attr, completion};
+    }
 
     /**
      * @brief general co_await
@@ -114,7 +229,12 @@ class pthread_joiner final {
 
   public:
     class promise_type final : public pthread_spawn_promise {
+        std::atomic<uint32_t> finished{}; /// for the pooled thread. `pthread_join` can't be used
+
       public:
+        promise_type() noexcept {
+            this->completion = &finished;
+        }
         constexpr auto final_suspend() noexcept {
             return std::experimental::suspend_always{};
         }
@@ -132,6 +252,7 @@ class pthread_joiner final {
   public:
     /**
      * @brief try to join the related thread
+     * @note  For the pooled thread, waits until the resume on it returns. The thread is not terminated
      * @see pthread_join
      * @throw system_error
      */
@@ -139,8 +260,10 @@ class pthread_joiner final {
 
     pthread_joiner(const pthread_joiner&) = delete;
     pthread_joiner& operator=(const pthread_joiner&) = delete;
-    pthread_joiner(pthread_joiner&&) = default;
-    pthread_joiner& operator=(pthread_joiner&&) = default;
+    /// @brief the moved one joins nothing
+    pthread_joiner(pthread_joiner&& rhs) noexcept;
+    /// @brief swap. `rhs` joins the previous thread at its destruction
+    pthread_joiner& operator=(pthread_joiner&& rhs) noexcept;
 
     /**
      * @brief allow access to the `tid`
@@ -161,10 +284,28 @@ class pthread_detacher final {
   public:
     class promise_type final : public pthread_spawn_promise {
       public:
-        // detacher doesn't care about the coroutine frame's life cycle
-        // it does nothing after `co_return`
-        constexpr auto final_suspend() noexcept {
-            return suspend_never{};
+        /// @brief the frame and the detacher. the last one destroys the frame
+        std::atomic<uint32_t> refs{2};
+
+      public:
+        // detacher doesn't care about the coroutine frame's life cycle,
+        // but its destructor reads the promise. the frame can be destroyed in the spawned thread
+        auto final_suspend() noexcept {
+            struct awaiter final {
+                promise_type* p;
+
+                constexpr bool await_ready() noexcept {
+                    return false;
+                }
+                /// @note the frame must be suspended before the detacher can see the count
+                bool await_suspend(coroutine_handle<void>) noexcept {
+                    // if the detacher is alive, it will destroy this frame
+                    return p->refs.fetch_sub(1, std::memory_order_acq_rel) != 1;
+                }
+                constexpr void await_resume() noexcept {
+                }
+            };
+            return awaiter{this};
         }
         auto get_return_object() noexcept {
             return pthread_detacher{this};
@@ -180,14 +321,17 @@ class pthread_detacher final {
   public:
     /**
      * @brief try to detach the related thread
+     * @note  Nothing to do for the pooled thread. It returns to the pool by itself
      * @see pthread_detach
      * @throw system_error
      */
     ~pthread_detacher() noexcept(false);
     pthread_detacher(const pthread_detacher&) = delete;
     pthread_detacher& operator=(const pthread_detacher&) = delete;
-    pthread_detacher(pthread_detacher&&) = default;
-    pthread_detacher& operator=(pthread_detacher&&) = default;
+    /// @brief the moved one detaches nothing
+    pthread_detacher(pthread_detacher&& rhs) noexcept;
+    /// @brief swap. `rhs` detaches the previous thread at its destruction
+    pthread_detacher& operator=(pthread_detacher&& rhs) noexcept;
 
     /**
      * @brief allow access to the `tid`
@@ -35,6 +35,18 @@ using std::experimental::suspend_never;
  * Types for easier coroutine promise/return type definition.
  */
 
+/**
+ * @brief For the `operator new/delete` which receive the coroutine's parameters.
+ *        GCC warns `-Wmismatched-new-delete` for the pair of the template `new` and the usual `delete`,
+ *        unless they are inlined into the coroutine. (the optimized build does it anyway)
+ * @ingroup Return
+ */
+#if defined(__GNUC__)
+#define COROUTINE_FRAME_OPERATOR [[gnu::always_inline]]
+#else
+#define COROUTINE_FRAME_OPERATOR
+#endif
+
 /**
  * @brief   `suspend_never`(initial) + `suspend_never`(final)
  * @ingroup Return
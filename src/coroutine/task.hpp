@@ -0,0 +1,260 @@
+/**
+ * @file coroutine/task.hpp
+ * @author github.com/luncliff (luncliff@gmail.com)
+ * @copyright CC BY 4.0
+ *
+ * @brief Lazy `task<T>`. Starts when it is awaited, and continues the awaiter with symmetric transfer
+ */
+#pragma once
+#ifndef LUNCLIFF_COROUTINE_TASK_HPP
+#define LUNCLIFF_COROUTINE_TASK_HPP
+#include <exception>
+#include <memory>
+#include <utility>
+#include <variant>
+
+#include <coroutine/frame_arena.hpp>
+#include <coroutine/return.h>
+
+namespace coro {
+
+template <typename T>
+class task;
+
+namespace internal {
+
+/**
+ * @brief `final_suspend` of the `task`. Transfer to the awaiter without the stack growth
+ * @ingroup Task
+ */
+struct task_final_awaiter final {
+    constexpr bool await_ready() const noexcept {
+        return false;
+    }
+    template <typename P>
+    coroutine_handle<void> await_suspend(coroutine_handle<P> coro) noexcept {
+        if (auto next = coro.promise().continuation)
+            return next;
+        return std::experimental::noop_coroutine();
+    }
+    constexpr void await_resume() const noexcept {
+    }
+};
+
+/**
+ * @brief Common part of the `task`'s promise. Lazy start, and the continuation for the `final_suspend`
+ * @note  The frame is from the `frame_arena` if the task function has its reference parameter
+ * @ingroup Task
+ */
+class task_promise_base : public arena_frame {
+    friend struct task_final_awaiter;
+
+    coroutine_handle<void> continuation = nullptr;
+
+  public:
+    suspend_always initial_suspend() noexcept {
+        return {};
+    }
+    task_final_awaiter final_suspend() noexcept {
+        return {};
+    }
+    void set_continuation(coroutine_handle<void> coro) noexcept {
+        continuation = coro;
+    }
+};
+
+/**
+ * @brief The result is stored in the promise. No allocation beyond the frame
+ * @ingroup Task
+ */
+template <typename T>
+class task_promise final : public task_promise_base {
+    std::variant<std::monostate, T, std::exception_ptr> result{};
+
+  public:
+    task<T> get_return_object() noexcept;
+
+    void unhandled_exception() noexcept {
+        result.template emplace<2>(std::current_exception());
+    }
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U&&, T>>>
+    void return_value(U&& value) noexcept(std::is_nothrow_constructible_v<T, U&&>) {
+        result.template emplace<1>(std::forward<U>(value));
+    }
+
+    /// @throw the exception from the coroutine body
+    T& get() & noexcept(false) {
+        if (result.index() == 2)
+            std::rethrow_exception(std::get<2>(result));
+        return std::get<1>(result);
+    }
+    T&& get() && noexcept(false) {
+        return std::move(get());
+    }
+};
+
+template <typename T>
+class task_promise<T&> final : public task_promise_base {
+    T* value = nullptr;
+    std::exception_ptr error{};
+
+  public:
+    task<T&> get_return_object() noexcept;
+
+    void unhandled_exception() noexcept {
+        error = std::current_exception();
+    }
+    void return_value(T& ref) noexcept {
+        value = std::addressof(ref);
+    }
+
+    T& get() noexcept(false) {
+        if (error)
+            std::rethrow_exception(error);
+        return *value;
+    }
+};
+
+template <>
+class task_promise<void> final : public task_promise_base {
+    std::exception_ptr error{};
+
+  public:
+    task<void> get_return_object() noexcept;
+
+    void unhandled_exception() noexcept {
+        error = std::current_exception();
+    }
+    constexpr void return_void() noexcept {
+    }
+
+    void get() noexcept(false) {
+        if (error)
+            std::rethrow_exception(error);
+    }
+};
+
+} // namespace internal
+
+/**
+ * @defgroup Task
+ * Lazy coroutine which returns a value to its awaiter
+ */
+
+/**
+ * @brief Lazy coroutine return type. The body starts when the `task` is awaited.
+ *        The result(value or exception) is delivered to the awaiter.
+ *
+ * @details When the body ends, the awaiter is resumed by symmetric transfer(`await_suspend` returns the handle).
+ * So a long chain of the tasks which complete synchronously doesn't grow the stack.
+ * The `task` owns the frame and destroys it in the destructor.
+ *
+ * @note GCC emits the tail call for the transfer only with the optimization. Debug builds can still grow the stack
+ *
+ * @code
+ * auto read_size(const char* path) -> task<size_t>;
+ *
+ * auto total(const char* a, const char* b) -> task<size_t> {
+ *     size_t x = co_await read_size(a); // exception from `read_size` is thrown here
+ *     size_t y = co_await read_size(b);
+ *     co_return x + y;
+ * }
+ * @endcode
+ *
+ * @tparam T Type of the result. `T&` and `void` are allowed
+ * @ingroup Task
+ */
+template <typename T = void>
+class task final {
+  public:
+    using promise_type = internal::task_promise<T>;
+    using value_type = T;
+
+  private:
+    coroutine_handle<promise_type> coro = nullptr;
+
+  private:
+    struct awaiter_base {
+        coroutine_handle<promise_type> coro;
+
+        bool await_ready() const noexcept {
+            return coro.done();
+        }
+        coroutine_handle<void> await_suspend(coroutine_handle<void> awaiting) noexcept {
+            coro.promise().set_continuation(awaiting);
+            return coro; // start the body in place of the awaiter
+        }
+    };
+
+  public:
+    task() noexcept = default;
+    explicit task(coroutine_handle<promise_type> handle) noexcept : coro{handle} {
+    }
+    ~task() noexcept {
+        if (coro)
+            coro.destroy();
+    }
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+    task(task&& rhs) noexcept : coro{std::exchange(rhs.coro, nullptr)} {
+    }
+    task& operator=(task&& rhs) noexcept {
+        std::swap(coro, rhs.coro);
+        return *this;
+    }
+
+  public:
+    /// @return true if the body has finished. Its result can be accessed without the suspension
+    bool is_ready() const noexcept {
+        return coro == nullptr || coro.done();
+    }
+    coroutine_handle<void> handle() const noexcept {
+        return coro;
+    }
+
+    /**
+     * @brief Start the body and wait for the result
+     * @note  The `task` must have a frame. The default constructed one can't be awaited
+     */
+    auto operator co_await() & noexcept {
+        struct awaiter final : awaiter_base {
+            decltype(auto) await_resume() noexcept(false) {
+                return this->coro.promise().get();
+            }
+        };
+        return awaiter{{coro}};
+    }
+    /**
+     * @brief Same with the lvalue version, but moves the result out of the promise
+     */
+    auto operator co_await() && noexcept {
+        struct awaiter final : awaiter_base {
+            decltype(auto) await_resume() noexcept(false) {
+                if constexpr (std::is_reference_v<T> || std::is_void_v<T>)
+                    return this->coro.promise().get();
+                else
+                    return std::move(this->coro.promise()).get();
+            }
+        };
+        return awaiter{{coro}};
+    }
+};
+
+namespace internal {
+
+template <typename T>
+task<T> task_promise<T>::get_return_object() noexcept {
+    return task<T>{coroutine_handle<task_promise>::from_promise(*this)};
+}
+template <typename T>
+task<T&> task_promise<T&>::get_return_object() noexcept {
+    return task<T&>{coroutine_handle<task_promise>::from_promise(*this)};
+}
+inline task<void> task_promise<void>::get_return_object() noexcept {
+    return task<void>{coroutine_handle<task_promise>::from_promise(*this)};
+}
+
+} // namespace internal
+} // namespace coro
+
+#endif // LUNCLIFF_COROUTINE_TASK_HPP
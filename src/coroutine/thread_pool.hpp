@@ -0,0 +1,348 @@
+/**
+ * @file coroutine/thread_pool.hpp
+ * @author github.com/luncliff (luncliff@gmail.com)
+ * @copyright CC BY 4.0
+ *
+ * @brief Fixed size, work-stealing thread pool for coroutines
+ */
+#pragma once
+#ifndef LUNCLIFF_COROUTINE_THREAD_POOL_HPP
+#define LUNCLIFF_COROUTINE_THREAD_POOL_HPP
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <coroutine/channel_mutex.hpp>
+#include <coroutine/channel_spsc.hpp> // for `internal::cache_line_size`
+
+namespace coro {
+namespace internal {
+
+/**
+ * @brief Chase-Lev deque of coroutine frames with fixed capacity.
+ *        The owner thread pushes/pops at the bottom(LIFO), the other threads steal from the top(FIFO)
+ * @see "Correct and Efficient Work-Stealing for Weak Memory Models" (Lê et al., PPoPP 2013)
+ * @ingroup ThreadPool
+ */
+class chase_lev_deque final {
+    static constexpr int64_t capacity = 256;
+    static constexpr int64_t mask = capacity - 1;
+
+    alignas(cache_line_size) std::atomic<int64_t> top{};
+    alignas(cache_line_size) std::atomic<int64_t> bottom{};
+    std::atomic<void*> slots[capacity]{};
+
+  public:
+    /**
+     * @note  Owner only
+     * @return false  The deque is full
+     */
+    bool push(void* frame) noexcept {
+        const int64_t b = bottom.load(std::memory_order_relaxed);
+        const int64_t t = top.load(std::memory_order_acquire);
+        if (b - t >= capacity)
+            return false;
+        slots[b & mask].store(frame, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_release); // publish the slot (and the frame) to the thieves
+        return true;
+    }
+    /**
+     * @note  Owner only
+     * @return void* `nullptr` if empty
+     */
+    void* pop() noexcept {
+        const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b) { // empty
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        void* frame = slots[b & mask].load(std::memory_order_relaxed);
+        if (t == b) { // the last one. race with the thieves
+            if (top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed) == false)
+                frame = nullptr;
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return frame;
+    }
+    /**
+     * @note  Any thread
+     * @return void* `nullptr` if empty or lost the race
+     */
+    void* steal() noexcept {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b)
+            return nullptr;
+        void* frame = slots[t & mask].load(std::memory_order_relaxed);
+        if (top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed) == false)
+            return nullptr;
+        return frame;
+    }
+    bool is_empty() const noexcept {
+        return bottom.load(std::memory_order_acquire) <= top.load(std::memory_order_acquire);
+    }
+};
+
+} // namespace internal
+
+/**
+ * @defgroup ThreadPool
+ * Work-stealing scheduler for the coroutines
+ */
+
+/**
+ * @brief Fixed size thread pool. Each worker has a Chase-Lev deque and a LIFO slot.
+ *        The other threads submit to the injection queue.
+ *
+ * @details Worker's scheduling order is
+ *
+ * 1. LIFO slot. The coroutine most recently woken(`post`) by this worker. Good for the cache locality.
+ *    To prevent starvation, the slot is used at most `lifo_limit` times in a row.
+ * 2. Local deque (bottom). Every `inject_interval` tick, the injection queue is checked first.
+ * 3. Injection queue. It has a lock, but the workers check its atomic size before the lock.
+ * 4. Steal from the other workers' deque (top), starting at a random victim.
+ * 5. Park on the futex until there is a new work.
+ *
+ * There is no central lock for the workers. Submitting from a worker never touches the injection queue.
+ *
+ * @code
+ * auto handle_request(thread_pool& pool, request_t req) -> frame_t {
+ *     co_await pool.schedule(); // continue in a worker
+ *     // ... CPU bound work ...
+ * }
+ * @endcode
+ *
+ * @note The destructor waits until all submitted coroutines are processed
+ * @ingroup ThreadPool
+ */
+class thread_pool final {
+    static constexpr uint32_t lifo_limit = 3;
+    static constexpr uint32_t inject_interval = 61;
+
+    struct worker_t final {
+        thread_pool* owner = nullptr;
+        internal::chase_lev_deque tasks{};
+        void* lifo = nullptr; /// owner only. can't be stolen
+        uint32_t lifo_count = 0;
+        uint32_t tick = 0;
+        uint64_t seed = 0; /// for the random victim selection
+        std::thread thread{};
+    };
+
+  private:
+    std::vector<std::unique_ptr<worker_t>> workers{};
+    std::mutex inject_mtx{};
+    std::deque<void*> injected{};
+    alignas(internal::cache_line_size) std::atomic<uint64_t> inject_size{};
+    alignas(internal::cache_line_size) std::atomic<uint32_t> epoch{}; /// futex word for the parking
+    std::atomic<uint32_t> idle{};
+    std::atomic<bool> stopping{};
+
+  private:
+    static worker_t*& current() noexcept {
+        thread_local worker_t* w = nullptr;
+        return w;
+    }
+    /// @return worker_t* `nullptr` if the current thread is not a worker of this pool
+    worker_t* local() noexcept {
+        worker_t* w = current();
+        return (w && w->owner == this) ? w : nullptr;
+    }
+
+    void inject(void* frame) noexcept(false) {
+        {
+            std::unique_lock lck{inject_mtx};
+            injected.push_back(frame);
+        }
+        inject_size.fetch_add(1, std::memory_order_release);
+    }
+    void* take_injected() noexcept(false) {
+        if (inject_size.load(std::memory_order_acquire) == 0)
+            return nullptr;
+        std::unique_lock lck{inject_mtx};
+        if (injected.empty())
+            return nullptr;
+        void* frame = injected.front();
+        injected.pop_front();
+        inject_size.fetch_sub(1, std::memory_order_relaxed);
+        return frame;
+    }
+    /// @brief wake a parked worker if there is
+    void notify() noexcept {
+        std::atomic_thread_fence(std::memory_order_seq_cst); // the new task -> `idle`
+        if (idle.load(std::memory_order_relaxed) == 0)
+            return;
+        epoch.fetch_add(1, std::memory_order_release);
+        internal::unpark(epoch, 1);
+    }
+
+    void* steal(worker_t& self) noexcept {
+        const size_t count = workers.size();
+        // xorshift
+        self.seed ^= self.seed << 13;
+        self.seed ^= self.seed >> 7;
+        self.seed ^= self.seed << 17;
+        const size_t start = self.seed % count;
+        for (size_t i = 0; i < count; ++i) {
+            worker_t& victim = *workers[(start + i) % count];
+            if (&victim == &self)
+                continue;
+            if (void* frame = victim.tasks.steal())
+                return frame;
+        }
+        return nullptr;
+    }
+    /// @brief local deque and the injection queue. No steal
+    void* find_queued(worker_t& self) noexcept(false) {
+        if (++self.tick % inject_interval == 0)
+            if (void* frame = take_injected())
+                return frame;
+        if (void* frame = self.tasks.pop())
+            return frame;
+        return take_injected();
+    }
+    void* find(worker_t& self) noexcept(false) {
+        if (self.lifo && self.lifo_count < lifo_limit) {
+            ++self.lifo_count;
+            return std::exchange(self.lifo, nullptr);
+        }
+        self.lifo_count = 0;
+        if (void* prev = std::exchange(self.lifo, nullptr)) { // reached the limit. let the older ones run first
+            void* frame = find_queued(self);
+            if (frame == nullptr)
+                return prev;
+            // push after the pop. or the next pop returns `prev` again
+            if (self.tasks.push(prev) == false)
+                inject(prev);
+            notify();
+            return frame;
+        }
+        if (void* frame = find_queued(self))
+            return frame;
+        return steal(self);
+    }
+    bool has_work() const noexcept {
+        if (inject_size.load(std::memory_order_acquire))
+            return true;
+        for (const auto& w : workers)
+            if (w->tasks.is_empty() == false)
+                return true;
+        return false;
+    }
+
+    void run(worker_t& self) noexcept(false) {
+        current() = &self;
+        while (true) {
+            if (void* frame = find(self)) {
+                coroutine_handle<void>::from_address(frame).resume();
+                continue;
+            }
+            // prepare to park. the submitters check `idle` after their push
+            const uint32_t e = epoch.load(std::memory_order_acquire);
+            idle.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst); // `idle` -> the queues
+            if (has_work() == false) {
+                if (stopping.load(std::memory_order_acquire)) {
+                    idle.fetch_sub(1, std::memory_order_relaxed);
+                    break;
+                }
+                internal::park_on(epoch, e);
+            }
+            idle.fetch_sub(1, std::memory_order_relaxed);
+        }
+        current() = nullptr;
+    }
+
+  public:
+    /**
+     * @param count number of the worker threads
+     */
+    explicit thread_pool(uint32_t count = std::thread::hardware_concurrency()) noexcept(false) {
+        if (count == 0)
+            count = 1;
+        workers.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            workers.emplace_back(std::make_unique<worker_t>());
+            workers.back()->owner = this;
+            workers.back()->seed = 0x9E37'79B9'7F4A'7C15ULL * (i + 1);
+        }
+        // start after all workers are ready. they access each other for the steal
+        for (auto& w : workers)
+            w->thread = std::thread{[this, w = w.get()]() { run(*w); }};
+    }
+    /**
+     * @brief Wait for the workers after all submitted coroutines are processed
+     */
+    ~thread_pool() noexcept(false) {
+        stopping.store(true, std::memory_order_release);
+        epoch.fetch_add(1, std::memory_order_release);
+        internal::unpark(epoch, INT_MAX);
+        for (auto& w : workers)
+            w->thread.join();
+    }
+    thread_pool(const thread_pool&) = delete;
+    thread_pool(thread_pool&&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+    thread_pool& operator=(thread_pool&&) = delete;
+
+  public:
+    uint32_t size() const noexcept {
+        return static_cast<uint32_t>(workers.size());
+    }
+
+    /**
+     * @brief Submit the coroutine to run later. The local deque of the worker, or the injection queue
+     */
+    void submit(coroutine_handle<void> coro) noexcept(false) {
+        worker_t* w = local();
+        if (w == nullptr || w->tasks.push(coro.address()) == false)
+            inject(coro.address());
+        notify();
+    }
+    /**
+     * @brief Wake the coroutine. In a worker, it goes to the LIFO slot and runs next
+     * @note  The previous occupant of the LIFO slot is moved to the local deque
+     */
+    void post(coroutine_handle<void> coro) noexcept(false) {
+        worker_t* w = local();
+        if (w == nullptr)
+            return submit(coro);
+        if (void* prev = std::exchange(w->lifo, coro.address())) {
+            if (w->tasks.push(prev) == false)
+                inject(prev);
+            notify(); // the displaced one can be stolen
+        }
+    }
+
+    /**
+     * @brief Awaitable to continue the coroutine in one of the workers
+     */
+    auto schedule() noexcept {
+        struct awaiter final {
+            thread_pool& pool;
+
+            constexpr bool await_ready() const noexcept {
+                return false;
+            }
+            void await_suspend(coroutine_handle<void> coro) noexcept(false) {
+                pool.submit(coro);
+            }
+            constexpr void await_resume() const noexcept {
+            }
+        };
+        return awaiter{*this};
+    }
+};
+
+} // namespace coro
+
+#endif // LUNCLIFF_COROUTINE_THREAD_POOL_HPP
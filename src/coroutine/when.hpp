@@ -0,0 +1,481 @@
+/**
+ * @file coroutine/when.hpp
+ * @author github.com/luncliff (luncliff@gmail.com)
+ * @copyright CC BY 4.0
+ *
+ * @brief `when_all` and `when_any` to await multiple awaitables concurrently
+ */
+#pragma once
+#ifndef LUNCLIFF_COROUTINE_WHEN_HPP
+#define LUNCLIFF_COROUTINE_WHEN_HPP
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <coroutine/return.h>
+
+namespace coro {
+namespace internal {
+
+template <typename A, typename = void>
+struct has_member_co_await : std::false_type {};
+template <typename A>
+struct has_member_co_await<A, std::void_t<decltype(std::declval<A>().operator co_await())>> : std::true_type {};
+
+template <typename A, typename = void>
+struct has_free_co_await : std::false_type {};
+template <typename A>
+struct has_free_co_await<A, std::void_t<decltype(operator co_await(std::declval<A>()))>> : std::true_type {};
+
+template <typename A, typename = void>
+struct has_await_ready : std::false_type {};
+template <typename A>
+struct has_await_ready<A, std::void_t<decltype(std::declval<A>().await_ready())>> : std::true_type {};
+
+template <typename A>
+constexpr bool is_awaitable_v = has_member_co_await<A>::value || has_free_co_await<A>::value || has_await_ready<A>::value;
+
+/// @brief the object which `co_await` uses for the awaitable
+template <typename A>
+decltype(auto) get_awaiter(A&& a) noexcept {
+    if constexpr (has_member_co_await<A>::value)
+        return std::forward<A>(a).operator co_await();
+    else if constexpr (has_free_co_await<A>::value)
+        return operator co_await(std::forward<A>(a));
+    else
+        return std::forward<A>(a);
+}
+
+/// @brief type of the `co_await` expression
+template <typename A>
+using await_result_t = decltype(get_awaiter(std::declval<A>()).await_resume());
+
+/// @brief `void` is `monostate`, `T&` is `reference_wrapper<T>`, the others are decayed
+template <typename R>
+using when_stored_t = std::conditional_t<
+    std::is_void_v<R>, std::monostate,
+    std::conditional_t<std::is_lvalue_reference_v<R>, std::reference_wrapper<std::remove_reference_t<R>>,
+                       std::remove_cv_t<std::remove_reference_t<R>>>>;
+
+/**
+ * @brief Result of a child. Written by the child, read by the parent after the join
+ * @ingroup When
+ */
+template <typename R>
+struct when_slot final {
+    using result_type = R;
+    using stored_type = when_stored_t<R>;
+
+    std::optional<stored_type> value{};
+    std::exception_ptr error{};
+
+    stored_type take() noexcept(false) {
+        if (error)
+            std::rethrow_exception(error);
+        return std::move(*value);
+    }
+};
+
+/**
+ * @brief Coroutine which awaits a child. Notifies the owner when it ends.
+ *        The owner destroys the frame
+ * @ingroup When
+ */
+class when_child final {
+  public:
+    /// @brief returns the coroutine to transfer. `noop_coroutine` if nothing to resume
+    using complete_fn = coroutine_handle<void> (*)(void* context, size_t index) noexcept;
+
+    class promise_type final {
+        friend class when_child;
+
+        void* context = nullptr;
+        size_t index = 0;
+        complete_fn complete = nullptr;
+        std::exception_ptr* error = nullptr;
+
+      public:
+        suspend_always initial_suspend() noexcept {
+            return {};
+        }
+        auto final_suspend() noexcept {
+            struct awaiter final {
+                constexpr bool await_ready() const noexcept {
+                    return false;
+                }
+                coroutine_handle<void> await_suspend(coroutine_handle<promise_type> coro) noexcept {
+                    // the frame can be destroyed in `complete`. read the members before it
+                    promise_type& p = coro.promise();
+                    return p.complete(p.context, p.index);
+                }
+                constexpr void await_resume() const noexcept {
+                }
+            };
+            return awaiter{};
+        }
+        void unhandled_exception() noexcept {
+            *error = std::current_exception();
+        }
+        constexpr void return_void() noexcept {
+        }
+        when_child get_return_object() noexcept {
+            return when_child{coroutine_handle<promise_type>::from_promise(*this)};
+        }
+    };
+
+  private:
+    coroutine_handle<promise_type> coro = nullptr;
+
+  public:
+    when_child() noexcept = default;
+    explicit when_child(coroutine_handle<promise_type> handle) noexcept : coro{handle} {
+    }
+    ~when_child() noexcept {
+        if (coro)
+            coro.destroy();
+    }
+    when_child(const when_child&) = delete;
+    when_child& operator=(const when_child&) = delete;
+    when_child(when_child&& rhs) noexcept : coro{std::exchange(rhs.coro, nullptr)} {
+    }
+    when_child& operator=(when_child&& rhs) noexcept {
+        std::swap(coro, rhs.coro);
+        return *this;
+    }
+
+    /// @note the child may complete and call `fn` before this function returns
+    void start(void* context, size_t index, complete_fn fn, std::exception_ptr* error) noexcept {
+        promise_type& p = coro.promise();
+        p.context = context;
+        p.index = index;
+        p.complete = fn;
+        p.error = error;
+        coro.resume();
+    }
+};
+
+template <typename A, typename S>
+when_child make_when_child(A&& awaitable, S& slot) {
+    if constexpr (std::is_void_v<typename S::result_type>) {
+        co_await std::forward<A>(awaitable);
+        slot.value.emplace();
+    } else {
+        slot.value.emplace(co_await std::forward<A>(awaitable));
+    }
+}
+
+/**
+ * @brief Countdown for the join. The parent is counted too, so it's resumed only after its suspension
+ * @ingroup When
+ */
+class when_counter final {
+    std::atomic<size_t> count;
+    coroutine_handle<void> parent = nullptr;
+
+  public:
+    explicit when_counter(size_t num_child) noexcept : count{num_child + 1} {
+    }
+
+    /// @return false  All children are done already. Don't suspend
+    bool try_await(coroutine_handle<void> coro) noexcept {
+        parent = coro;
+        return count.fetch_sub(1, std::memory_order_acq_rel) > 1;
+    }
+    /// @return the parent if this is the last arrival
+    coroutine_handle<void> arrive() noexcept {
+        if (count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            return parent;
+        return std::experimental::noop_coroutine();
+    }
+
+    static coroutine_handle<void> on_complete(void* context, size_t) noexcept {
+        return static_cast<when_counter*>(context)->arrive();
+    }
+};
+
+/**
+ * @brief Shared state of `when_any`. One allocation for the awaitables, the results and the handles of the children.
+ *        (Each child has its own frame.) The children and the awaiter hold the references. The last one deletes it
+ * @ingroup When
+ */
+template <typename Inputs, typename Slots, typename Children>
+struct when_any_state final {
+    static constexpr size_t none = SIZE_MAX;
+
+    Inputs inputs;
+    Slots slots{};
+    Children children{};
+    std::atomic<size_t> refs;
+    std::atomic<size_t> first{none};
+    std::atomic<uint32_t> gate{2}; /// the first completion and the end of the start
+    coroutine_handle<void> parent = nullptr;
+
+    when_any_state(Inputs&& values, size_t count) noexcept(false) : inputs{std::move(values)}, refs{count + 1} {
+    }
+
+    void release() noexcept {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete this;
+    }
+    /// @return false  The parent must continue without the suspension
+    bool try_await(coroutine_handle<void> coro) noexcept {
+        parent = coro;
+        return gate.fetch_sub(1, std::memory_order_acq_rel) > 1;
+    }
+    static coroutine_handle<void> on_complete(void* context, size_t index) noexcept {
+        auto* self = static_cast<when_any_state*>(context);
+        coroutine_handle<void> next = std::experimental::noop_coroutine();
+        size_t expected = none;
+        if (self->first.compare_exchange_strong(expected, index, std::memory_order_acq_rel))
+            if (self->gate.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                next = self->parent;
+        self->release(); // may destroy this child's frame. it is suspended
+        return next;
+    }
+};
+
+} // namespace internal
+
+/**
+ * @defgroup When
+ * Combinators to await multiple awaitables concurrently
+ */
+
+/**
+ * @brief Awaitable of `when_all` for a fixed number of awaitables
+ * @ingroup When
+ */
+template <typename... A>
+class when_all_awaitable final {
+    using index_sequence_t = std::index_sequence_for<A...>;
+
+    std::tuple<A...> inputs;
+    std::tuple<internal::when_slot<internal::await_result_t<A>>...> slots{};
+    std::array<internal::when_child, sizeof...(A)> children{};
+    internal::when_counter counter{sizeof...(A)};
+
+  private:
+    /// @throw std::bad_alloc  No child is started for the case
+    template <size_t... I>
+    void create(std::index_sequence<I...>) noexcept(false) {
+        ((std::get<I>(children) = internal::make_when_child(std::get<I>(std::move(inputs)), std::get<I>(slots))),
+         ...);
+    }
+    template <size_t... I>
+    void start(std::index_sequence<I...>) noexcept {
+        (std::get<I>(children).start(&counter, I, internal::when_counter::on_complete, &std::get<I>(slots).error),
+         ...);
+    }
+    template <size_t... I>
+    auto take(std::index_sequence<I...>) noexcept(false) {
+        return std::make_tuple(std::get<I>(slots).take()...);
+    }
+
+  public:
+    explicit when_all_awaitable(A&&... awaitables) noexcept(false) : inputs{std::forward<A>(awaitables)...} {
+    }
+    when_all_awaitable(const when_all_awaitable&) = delete;
+    when_all_awaitable& operator=(const when_all_awaitable&) = delete;
+
+    constexpr bool await_ready() const noexcept {
+        return sizeof...(A) == 0;
+    }
+    /// @throw The exception from the allocation of the children. The awaiting coroutine receives it
+    bool await_suspend(coroutine_handle<void> coro) noexcept(false) {
+        create(index_sequence_t{});
+        start(index_sequence_t{});
+        return counter.try_await(coro);
+    }
+    /**
+     * @return std::tuple of the results. `void` is `std::monostate`
+     * @throw  The exception of the first(by the argument order) failed awaitable
+     */
+    auto await_resume() noexcept(false) {
+        return take(index_sequence_t{});
+    }
+};
+
+/**
+ * @brief Awaitable of `when_all` for a range of the awaitables
+ * @ingroup When
+ */
+template <typename Range>
+class when_all_range_awaitable final {
+    using element_t = decltype(*std::begin(std::declval<Range&>()));
+    using input_t = std::conditional_t<std::is_lvalue_reference_v<Range>, element_t, std::remove_reference_t<element_t>&&>;
+    using slot_t = internal::when_slot<internal::await_result_t<input_t>>;
+
+    Range inputs;
+    std::vector<slot_t> slots{};
+    std::vector<internal::when_child> children{};
+    internal::when_counter counter;
+
+  public:
+    explicit when_all_range_awaitable(Range&& range) noexcept(false)
+        : inputs{std::forward<Range>(range)}, counter{static_cast<size_t>(std::distance(std::begin(inputs), std::end(inputs)))} {
+    }
+    when_all_range_awaitable(const when_all_range_awaitable&) = delete;
+    when_all_range_awaitable& operator=(const when_all_range_awaitable&) = delete;
+
+    bool await_ready() const noexcept {
+        return std::begin(inputs) == std::end(inputs);
+    }
+    bool await_suspend(coroutine_handle<void> coro) noexcept(false) {
+        const size_t count = std::distance(std::begin(inputs), std::end(inputs));
+        // no reallocation after the children start. they refer the slots
+        slots.resize(count);
+        children.reserve(count);
+        size_t i = 0;
+        for (auto&& input : inputs)
+            children.emplace_back(internal::make_when_child(static_cast<input_t>(input), slots[i++]));
+        for (i = 0; i < count; ++i)
+            children[i].start(&counter, i, internal::when_counter::on_complete, &slots[i].error);
+        return counter.try_await(coro);
+    }
+    /**
+     * @return std::vector of the results in the order of the range
+     * @throw  The exception of the first failed awaitable
+     */
+    auto await_resume() noexcept(false) {
+        std::vector<typename slot_t::stored_type> results{};
+        results.reserve(slots.size());
+        for (auto& slot : slots)
+            results.emplace_back(slot.take());
+        return results;
+    }
+};
+
+/**
+ * @brief Start all awaitables, and continue after all of them are done
+ *
+ * @details Each awaitable is awaited in a small child coroutine. The children are started in the order,
+ * and the last completion resumes the parent(symmetric transfer). The results are stored in the awaitable,
+ * which lives in the frame of the parent.
+ *
+ * @code
+ * auto [user, stock] = co_await when_all(fetch_user(id), fetch_stock(item));
+ * @endcode
+ *
+ * @note The lvalue awaitables are referenced. The rvalue ones are moved into the `when_all_awaitable`
+ * @ingroup When
+ */
+template <typename... A, typename = std::enable_if_t<(internal::is_awaitable_v<A> && ...)>>
+auto when_all(A&&... awaitables) noexcept(false) {
+    return when_all_awaitable<A...>{std::forward<A>(awaitables)...};
+}
+
+/**
+ * @brief `when_all` for a range(`std::vector` or the others with `begin`/`end`) of the awaitables
+ * @code
+ * std::vector<task<int>> requests = ...;
+ * std::vector<int> responses = co_await when_all(std::move(requests));
+ * @endcode
+ * @ingroup When
+ */
+template <typename Range, typename = std::enable_if_t<!internal::is_awaitable_v<Range>>,
+          typename = decltype(std::begin(std::declval<Range&>()))>
+auto when_all(Range&& range) noexcept(false) {
+    return when_all_range_awaitable<Range>{std::forward<Range>(range)};
+}
+
+/**
+ * @brief Awaitable of `when_any`
+ * @ingroup When
+ */
+template <typename... A>
+class when_any_awaitable final {
+    using index_sequence_t = std::index_sequence_for<A...>;
+    using slots_t = std::tuple<internal::when_slot<internal::await_result_t<A>>...>;
+    using state_t = internal::when_any_state<std::tuple<A...>, slots_t, std::array<internal::when_child, sizeof...(A)>>;
+
+    state_t* state;
+    bool started = false;
+
+  private:
+    /// @throw std::bad_alloc  No child is started for the case
+    template <size_t... I>
+    void create(std::index_sequence<I...>) noexcept(false) {
+        auto& s = *state;
+        ((std::get<I>(s.children) = internal::make_when_child(std::get<I>(std::move(s.inputs)), std::get<I>(s.slots))),
+         ...);
+    }
+    template <size_t... I>
+    void start(std::index_sequence<I...>) noexcept {
+        auto& s = *state;
+        (std::get<I>(s.children).start(state, I, state_t::on_complete, &std::get<I>(s.slots).error), ...);
+    }
+    using result_t = std::variant<internal::when_stored_t<internal::await_result_t<A>>...>;
+
+    template <size_t I = 0>
+    result_t take(size_t index) noexcept(false) {
+        if constexpr (I + 1 < sizeof...(A)) {
+            if (index != I)
+                return take<I + 1>(index);
+        }
+        return result_t{std::in_place_index<I>, std::get<I>(state->slots).take()};
+    }
+
+  public:
+    explicit when_any_awaitable(A&&... awaitables) noexcept(false)
+        : state{new state_t{std::tuple<A...>{std::forward<A>(awaitables)...}, sizeof...(A)}} {
+    }
+    ~when_any_awaitable() noexcept {
+        if (started)
+            state->release();
+        else
+            delete state; // no child holds the state
+    }
+    when_any_awaitable(const when_any_awaitable&) = delete;
+    when_any_awaitable& operator=(const when_any_awaitable&) = delete;
+
+    constexpr bool await_ready() const noexcept {
+        static_assert(sizeof...(A) > 0, "when_any requires at least 1 awaitable");
+        return false;
+    }
+    /// @throw The exception from the allocation of the children. The awaiting coroutine receives it
+    bool await_suspend(coroutine_handle<void> coro) noexcept(false) {
+        create(index_sequence_t{});
+        started = true; // the children hold the state from now
+        start(index_sequence_t{});
+        return state->try_await(coro);
+    }
+    /**
+     * @return std::variant of the results. Its `index()` is the first completed awaitable
+     * @throw  The exception of the first completed awaitable
+     */
+    result_t await_resume() noexcept(false) {
+        return take(state->first.load(std::memory_order_acquire));
+    }
+};
+
+/**
+ * @brief Start all awaitables, and continue when one of them is done
+ *
+ * @details The parent is resumed exactly once, by the first completion.
+ * The others keep running, and their results are discarded.
+ * The awaitables and the results are kept in one allocation until the last child ends. Each child is its own frame.
+ *
+ * @code
+ * auto result = co_await when_any(query(primary), query(replica));
+ * @endcode
+ *
+ * @note The lvalue awaitables are referenced. They must live until all of them are done
+ * @ingroup When
+ */
+template <typename... A, typename = std::enable_if_t<(internal::is_awaitable_v<A> && ...)>>
+auto when_any(A&&... awaitables) noexcept(false) {
+    return when_any_awaitable<A...>{std::forward<A>(awaitables)...};
+}
+
+} // namespace coro
+
+#endif // LUNCLIFF_COROUTINE_WHEN_HPP
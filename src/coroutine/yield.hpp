@@ -6,9 +6,14 @@
  */
 #ifndef COROUTINE_YIELD_HPP
 #define COROUTINE_YIELD_HPP
+#include <array>
+#include <exception>
 #include <iterator>
+#include <memory>
+#include <type_traits>
 
 #include <coroutine/return.h>
+#include <gsl/gsl>
 
 namespace coro {
 
@@ -152,6 +157,451 @@ class enumerable {
     };
 };
 
+/**
+ * @brief Marker for `co_yield` of the nested generator. Its elements are yielded in place
+ * @see recursive_enumerable
+ */
+template <typename R>
+struct elements_of final {
+    R range;
+};
+template <typename R>
+elements_of(R&&) -> elements_of<R&&>;
+
+/**
+ * @brief Generator which can yield the elements of the nested one with `co_yield elements_of(...)`
+ *
+ * @details The root promise holds the innermost(leaf) generator. The iterator resumes the leaf directly,
+ * so each element costs O(1) regardless of the depth. When the leaf ends, its parent continues.
+ * The exception from the nested one is thrown at the parent's `co_yield elements_of(...)`.
+ *
+ * @code
+ * auto walk(const node_t& node) -> recursive_enumerable<const node_t> {
+ *     co_yield node;
+ *     for (const node_t& child : node.children)
+ *         co_yield elements_of(walk(child));
+ * }
+ * @endcode
+ *
+ * @tparam T Type of the element
+ */
+template <typename T>
+class recursive_enumerable {
+  public:
+    class promise_type;
+    class iterator;
+
+    using value_type = T;
+    using reference = value_type&;
+    using pointer = value_type*;
+
+  private:
+    coro::coroutine_handle<promise_type> coro{};
+
+  public:
+    recursive_enumerable(const recursive_enumerable&) = delete;
+    recursive_enumerable& operator=(const recursive_enumerable&) = delete;
+    recursive_enumerable(recursive_enumerable&& rhs) noexcept : coro{rhs.coro} {
+        rhs.coro = nullptr;
+    }
+    recursive_enumerable& operator=(recursive_enumerable&& rhs) noexcept {
+        std::swap(coro, rhs.coro);
+        return *this;
+    }
+    recursive_enumerable() noexcept = default;
+    explicit recursive_enumerable(coro::coroutine_handle<promise_type> rh) noexcept : coro{rh} {
+    }
+    /// @note The nested ones are destroyed by their parents' frame
+    ~recursive_enumerable() noexcept {
+        if (coro)
+            coro.destroy();
+    }
+
+  public:
+    iterator begin() noexcept(false) {
+        if (coro) {
+            coro.promise().pull();
+            if (coro.done())
+                return iterator{nullptr};
+        }
+        return iterator{coro};
+    }
+    iterator end() noexcept {
+        return iterator{nullptr};
+    }
+
+  public:
+    class promise_type final : public promise_aa {
+        friend class iterator;
+        friend class recursive_enumerable;
+
+        pointer current = nullptr;
+        promise_type* root = this;
+        promise_type* parent = nullptr;
+        promise_type* leaf = this; /// valid in the root
+        std::exception_ptr error{};
+
+      private:
+        coro::coroutine_handle<promise_type> handle() noexcept {
+            return coro::coroutine_handle<promise_type>::from_promise(*this);
+        }
+
+        /**
+         * @brief Resume the leaf until it yields a value. Go down to the new nested one, and up to the parent
+         *        when the leaf ends. For the root only
+         * @throw The exception from the root
+         */
+        void pull() noexcept(false) {
+            while (true) {
+                promise_type* p = leaf;
+                p->handle().resume();
+                if (leaf != p) // `co_yield elements_of(...)`. start the nested one
+                    continue;
+                if (p->handle().done() == false) // `co_yield value`
+                    return;
+                if (p == this)
+                    break;
+                leaf = p->parent; // continue after `co_yield elements_of(...)`
+            }
+            if (error)
+                std::rethrow_exception(error);
+        }
+
+      public:
+        recursive_enumerable get_return_object() noexcept {
+            return recursive_enumerable{handle()};
+        }
+        void unhandled_exception() noexcept {
+            error = std::current_exception();
+        }
+        /// @brief  `co_yield` expression. for reference
+        auto yield_value(reference ref) noexcept {
+            current = std::addressof(ref);
+            return std::experimental::suspend_always{};
+        }
+        /// @brief  `co_yield` expression. for r-value
+        auto yield_value(value_type&& v) noexcept {
+            return yield_value(v);
+        }
+        /// @brief  `co_yield elements_of(...)`. The argument lives until the nested one ends
+        template <typename R>
+        auto yield_value(elements_of<R> nested) noexcept {
+            static_assert(std::is_same_v<std::remove_cv_t<std::remove_reference_t<R>>, recursive_enumerable>,
+                          "expect `elements_of(recursive_enumerable<T>)`");
+            struct awaiter final {
+                promise_type* self;
+                promise_type* child;
+
+                bool await_ready() const noexcept {
+                    return child == nullptr;
+                }
+                void await_suspend(coro::coroutine_handle<void>) noexcept {
+                    child->root = self->root;
+                    child->parent = self;
+                    self->root->leaf = child;
+                }
+                void await_resume() noexcept(false) {
+                    if (child && child->error)
+                        std::rethrow_exception(child->error);
+                }
+            };
+            auto& range = nested.range;
+            return awaiter{this, range.coro ? std::addressof(range.coro.promise()) : nullptr};
+        }
+
+        /**
+         * @brief `co_return` expression. There should be no more access to the value.
+         */
+        void return_void() noexcept {
+            current = nullptr;
+        }
+    };
+
+    class iterator final {
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = ptrdiff_t;
+        using value_type = T;
+        using reference = value_type&;
+        using pointer = value_type*;
+
+      public:
+        coro::coroutine_handle<promise_type> coro; /// the root
+
+      public:
+        /// @see recursive_enumerable::end()
+        explicit iterator(std::nullptr_t) noexcept : coro{nullptr} {
+        }
+        /// @see recursive_enumerable::begin()
+        explicit iterator(coro::coroutine_handle<promise_type> handle) noexcept : coro{handle} {
+        }
+
+      public:
+        /// @brief post increment is prohibited
+        iterator& operator++(int) = delete;
+        iterator& operator++() noexcept(false) {
+            coro.promise().pull();
+            if (coro.done())
+                coro = nullptr;
+            return *this;
+        }
+
+        pointer operator->() noexcept {
+            return coro.promise().leaf->current;
+        }
+        reference operator*() noexcept {
+            return *(this->operator->());
+        }
+
+        bool operator==(const iterator& rhs) const noexcept {
+            return this->coro == rhs.coro;
+        }
+        bool operator!=(const iterator& rhs) const noexcept {
+            return !(*this == rhs);
+        }
+    };
+};
+
+/**
+ * @brief Generator which resumes once per chunk. `co_yield` copies the value to the buffer in the promise,
+ *        and suspends only when the buffer is full(or at the end).
+ *
+ * @details For the small values(integers, tokens), the resume of each element costs more than the work.
+ * The consumer can take the chunks(`gsl::span<T>`) with `chunks()`,
+ * or iterate the elements with `begin()`/`end()`. Both resume the body once per `N` elements.
+ *
+ * @code
+ * auto tokens(std::string_view text) -> chunked_enumerable<token_t>;
+ *
+ * auto g = tokens(text);
+ * for (gsl::span<token_t> chunk : g.chunks())
+ *     process(chunk); // up to 64 tokens
+ * @endcode
+ *
+ * @tparam T Type of the element. Default constructible and copy/move assignable
+ * @tparam N Size of the chunk
+ */
+template <typename T, size_t N = 64>
+class chunked_enumerable {
+    static_assert(N > 0);
+
+  public:
+    class promise_type;
+    class iterator;
+    class chunk_iterator;
+
+    using value_type = T;
+    using reference = value_type&;
+    using pointer = value_type*;
+    using chunk_type = gsl::span<value_type>;
+
+  private:
+    coro::coroutine_handle<promise_type> coro{};
+
+  private:
+    /// @brief Resume the body for the next chunk. `false` if there is no more element
+    static bool fill(coro::coroutine_handle<promise_type> coro) noexcept(false) {
+        promise_type& p = coro.promise();
+        p.count = 0;
+        if (coro.done())
+            return false;
+        coro.resume();
+        return p.count > 0;
+    }
+
+  public:
+    chunked_enumerable(const chunked_enumerable&) = delete;
+    chunked_enumerable& operator=(const chunked_enumerable&) = delete;
+    chunked_enumerable(chunked_enumerable&& rhs) noexcept : coro{rhs.coro} {
+        rhs.coro = nullptr;
+    }
+    chunked_enumerable& operator=(chunked_enumerable&& rhs) noexcept {
+        std::swap(coro, rhs.coro);
+        return *this;
+    }
+    chunked_enumerable() noexcept = default;
+    explicit chunked_enumerable(coro::coroutine_handle<promise_type> rh) noexcept : coro{rh} {
+    }
+    ~chunked_enumerable() noexcept {
+        if (coro)
+            coro.destroy();
+    }
+
+  public:
+    iterator begin() noexcept(false) {
+        if (coro && fill(coro))
+            return iterator{coro};
+        return iterator{nullptr};
+    }
+    iterator end() noexcept {
+        return iterator{nullptr};
+    }
+
+    /**
+     * @brief Range of the chunks. Use it instead of `begin()`/`end()`. Not both
+     * @note The range doesn't own the frame. `chunks()` of the temporary is deleted
+     */
+    auto chunks() && = delete;
+    auto chunks() & noexcept {
+        struct range_t final {
+            coro::coroutine_handle<promise_type> coro;
+
+            chunk_iterator begin() noexcept(false) {
+                if (coro && fill(coro))
+                    return chunk_iterator{coro};
+                return chunk_iterator{nullptr};
+            }
+            chunk_iterator end() noexcept {
+                return chunk_iterator{nullptr};
+            }
+        };
+        return range_t{coro};
+    }
+
+  public:
+    class promise_type final : public promise_aa {
+        friend class iterator;
+        friend class chunk_iterator;
+        friend class chunked_enumerable;
+
+        std::array<value_type, N> buffer{};
+        size_t count = 0;
+
+      public:
+        chunked_enumerable get_return_object() noexcept {
+            return chunked_enumerable{coro::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        void unhandled_exception() noexcept(false) {
+            throw;
+        }
+
+        /// @brief suspend only if the buffer is full
+        struct yield_awaiter final {
+            bool full;
+
+            constexpr bool await_ready() const noexcept {
+                return !full;
+            }
+            constexpr void await_suspend(coro::coroutine_handle<void>) const noexcept {
+            }
+            constexpr void await_resume() const noexcept {
+            }
+        };
+
+        /// @brief  `co_yield` expression. The value is copied to the buffer
+        yield_awaiter yield_value(const value_type& value) noexcept(std::is_nothrow_copy_assignable_v<T>) {
+            buffer[count++] = value;
+            return {count == N};
+        }
+        /// @brief  `co_yield` expression. for r-value
+        yield_awaiter yield_value(value_type&& value) noexcept(std::is_nothrow_move_assignable_v<T>) {
+            buffer[count++] = std::move(value);
+            return {count == N};
+        }
+        /**
+         * @brief `co_return` expression. The rest of the buffer is the last chunk
+         */
+        void return_void() noexcept {
+        }
+    };
+
+    /// @brief Iterator of the elements. Resumes the body at the end of each chunk
+    class iterator final {
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = ptrdiff_t;
+        using value_type = T;
+        using reference = value_type&;
+        using pointer = value_type*;
+
+      public:
+        coro::coroutine_handle<promise_type> coro;
+        pointer current = nullptr;
+        pointer last = nullptr; /// end of the current chunk
+
+      private:
+        void reset() noexcept {
+            promise_type& p = coro.promise();
+            current = p.buffer.data();
+            last = current + p.count;
+        }
+
+      public:
+        /// @see chunked_enumerable::end()
+        explicit iterator(std::nullptr_t) noexcept : coro{nullptr} {
+        }
+        /// @see chunked_enumerable::begin()
+        explicit iterator(coro::coroutine_handle<promise_type> handle) noexcept : coro{handle} {
+            reset();
+        }
+
+      public:
+        /// @brief post increment is prohibited
+        iterator& operator++(int) = delete;
+        iterator& operator++() noexcept(false) {
+            if (++current != last) // no resume in the chunk
+                return *this;
+            if (fill(coro))
+                reset();
+            else
+                coro = nullptr, current = last = nullptr;
+            return *this;
+        }
+
+        pointer operator->() noexcept {
+            return current;
+        }
+        reference operator*() noexcept {
+            return *current;
+        }
+
+        bool operator==(const iterator& rhs) const noexcept {
+            return this->current == rhs.current;
+        }
+        bool operator!=(const iterator& rhs) const noexcept {
+            return !(*this == rhs);
+        }
+    };
+
+    /// @brief Iterator of the chunks. Each increment resumes the body once
+    class chunk_iterator final {
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = ptrdiff_t;
+        using value_type = chunk_type;
+        using reference = chunk_type;
+
+      public:
+        coro::coroutine_handle<promise_type> coro;
+
+      public:
+        explicit chunk_iterator(std::nullptr_t) noexcept : coro{nullptr} {
+        }
+        explicit chunk_iterator(coro::coroutine_handle<promise_type> handle) noexcept : coro{handle} {
+        }
+
+      public:
+        chunk_iterator& operator++(int) = delete;
+        chunk_iterator& operator++() noexcept(false) {
+            if (fill(coro) == false)
+                coro = nullptr;
+            return *this;
+        }
+
+        chunk_type operator*() noexcept {
+            promise_type& p = coro.promise();
+            return chunk_type{p.buffer.data(), p.count};
+        }
+
+        bool operator==(const chunk_iterator& rhs) const noexcept {
+            return this->coro == rhs.coro;
+        }
+        bool operator!=(const chunk_iterator& rhs) const noexcept {
+            return !(*this == rhs);
+        }
+    };
+};
+
 } // namespace coro
 
 #endif // COROUTINE_YIELD_HPP
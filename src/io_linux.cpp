@@ -14,6 +14,30 @@ namespace coro {
 
 epoll_owner iep{}, oep{}; // inbound, outbound
 
+io_work_pool& net_work_pool() noexcept {
+    static io_work_pool pool{};
+    return pool;
+}
+
+/// @brief the coroutine of the event. `nullptr` for the stale completion of the pooled work
+static coroutine_handle<void> to_coroutine(const epoll_event& e) noexcept {
+    if (io_work_pool::is_token(e.data.u64))
+        return net_work_pool().resolve(io_work_pool::from_token(e.data.u64));
+    return coroutine_handle<void>::from_address(e.data.ptr);
+}
+
+namespace internal {
+
+void submit_pooled(io_work_ticket ticket, bool outbound) noexcept(false) {
+    const io_work_t& work = net_work_pool().at(ticket);
+    epoll_event req{};
+    req.events = (outbound ? EPOLLOUT : EPOLLIN) | EPOLLONESHOT | EPOLLET;
+    req.data.u64 = io_work_pool::token(ticket);
+    (outbound ? oep : iep).try_add(work.handle, req); // throws if epoll_ctl fails
+}
+
+} // namespace internal
+
 void poll_net_tasks(uint64_t nano) noexcept(false) {
     const auto half_time = duration_cast<milliseconds>(nanoseconds{nano} / 2);
     // event buffer for this poll
@@ -23,16 +47,14 @@ void poll_net_tasks(uint64_t nano) noexcept(false) {
     {
         auto count = iep.wait(half_time.count(), {buf.get(), buf_sz});
         for (auto i = 0u; i < count; ++i)
-            if (auto coro =
-                    coro::coroutine_handle<void>::from_address(buf[i].data.ptr))
+            if (auto coro = to_coroutine(buf[i]))
                 coro.resume();
     }
     // resume outbound coroutines
     {
         auto count = oep.wait(half_time.count(), {buf.get(), buf_sz});
         for (auto i = 0u; i < count; ++i)
-            if (auto coro =
-                    coro::coroutine_handle<void>::from_address(buf[i].data.ptr))
+            if (auto coro = to_coroutine(buf[i]))
                 coro.resume();
     }
 }
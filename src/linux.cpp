@@ -3,8 +3,12 @@
  */
 #include <coroutine/linux.h>
 
+#include <algorithm>
+#include <cstdio>
 #include <fcntl.h>
 #include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 using namespace std;
@@ -130,4 +134,266 @@ void event::reset() noexcept(false) {
     this->state = static_cast<uint64_t>(fd);
 }
 
+shm_segment::shm_segment(size_t len) noexcept(false)
+    : memfd{-1}, efds{-1, -1}, addr{MAP_FAILED}, length{len} {
+    memfd = memfd_create("coro::shm_segment", MFD_CLOEXEC);
+    if (memfd == -1)
+        throw system_error{errno, system_category(), "memfd_create"};
+    for (auto& efd : efds)
+        if ((efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1) {
+            const auto ec = errno;
+            release();
+            throw system_error{ec, system_category(), "eventfd"};
+        }
+    if (ftruncate(memfd, length) == -1 ||
+        (addr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0)) == MAP_FAILED) {
+        const auto ec = errno;
+        release();
+        throw system_error{ec, system_category(), "ftruncate|mmap"};
+    }
+}
+
+shm_segment::shm_segment(int64_t fd, int64_t efd0, int64_t efd1) noexcept(false)
+    : memfd{fd}, efds{efd0, efd1}, addr{MAP_FAILED}, length{} {
+    struct stat info {};
+    if (fstat(memfd, &info) == -1 ||
+        (addr = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0)) == MAP_FAILED) {
+        const auto ec = errno;
+        release();
+        throw system_error{ec, system_category(), "fstat|mmap"};
+    }
+    length = info.st_size;
+}
+
+shm_segment::~shm_segment() noexcept {
+    release();
+}
+
+void shm_segment::release() noexcept {
+    if (addr != MAP_FAILED)
+        munmap(addr, length);
+    for (auto efd : efds)
+        if (efd != -1)
+            close(efd);
+    if (memfd != -1)
+        close(memfd);
+    addr = MAP_FAILED;
+    efds[0] = efds[1] = memfd = -1;
+}
+
+void* shm_segment::data() const noexcept {
+    return addr;
+}
+size_t shm_segment::size() const noexcept {
+    return length;
+}
+int64_t shm_segment::fd() const noexcept {
+    return memfd;
+}
+int64_t shm_segment::event_fd(uint32_t index) const noexcept {
+    return efds[index];
+}
+
+void shm_segment::notify(uint32_t index) noexcept(false) {
+    return notify_event(efds[index]);
+}
+
+void shm_segment::consume(uint32_t index) noexcept(false) {
+    uint64_t counter = 0;
+    if (read(efds[index], &counter, sizeof(counter)) == -1 && errno != EAGAIN)
+        throw system_error{errno, system_category(), "read"};
+}
+
+/// @brief read the list format of `/sys`. e.g. "0-3,8,10-11"
+template <typename Fn>
+static bool read_cpu_list(const string& path, Fn&& fn) noexcept(false) {
+    FILE* fp = fopen(path.c_str(), "r");
+    if (fp == nullptr)
+        return false;
+    uint32_t first = 0, last = 0;
+    while (fscanf(fp, "%u", &first) == 1) {
+        last = first;
+        const int sep = fgetc(fp);
+        if (sep == '-' && fscanf(fp, "%u", &last) == 1)
+            fgetc(fp); // ',' or '\n'
+        for (uint32_t id = first; id <= last; ++id)
+            fn(id);
+    }
+    fclose(fp);
+    return true;
+}
+
+static uint32_t read_id(const string& path, uint32_t fallback) noexcept {
+    FILE* fp = fopen(path.c_str(), "r");
+    if (fp == nullptr)
+        return fallback;
+    int value = -1;
+    if (fscanf(fp, "%d", &value) != 1 || value < 0) // -1 if unknown
+        value = static_cast<int>(fallback);
+    fclose(fp);
+    return static_cast<uint32_t>(value);
+}
+
+cpu_topology::cpu_topology(const char* root) noexcept(false) {
+    const string base{root};
+    if (read_cpu_list(base + "/cpu/online", [this](uint32_t id) { cpus.push_back(cpu_t{id, id, 0, 0}); }) == false)
+        throw system_error{errno, system_category(), "fopen"};
+
+    for (cpu_t& cpu : cpus) {
+        const string dir = base + "/cpu/cpu" + to_string(cpu.id) + "/topology/";
+        cpu.core = read_id(dir + "core_id", cpu.id);
+        cpu.package = read_id(dir + "physical_package_id", 0);
+    }
+    // without NUMA, all CPUs are in the node 0
+    read_cpu_list(base + "/node/online", [this, &base](uint32_t node) {
+        node_count = max(node_count, node + 1);
+        read_cpu_list(base + "/node/node" + to_string(node) + "/cpulist", [this, node](uint32_t id) {
+            if (auto* cpu = const_cast<cpu_t*>(find(id)))
+                cpu->node = node;
+        });
+    });
+}
+
+const cpu_topology& cpu_topology::current() noexcept(false) {
+    static const cpu_topology topology{};
+    return topology;
+}
+
+gsl::span<const cpu_topology::cpu_t> cpu_topology::list() const noexcept {
+    return {cpus.data(), cpus.size()};
+}
+
+const cpu_topology::cpu_t* cpu_topology::find(uint32_t id) const noexcept {
+    auto it = lower_bound(cpus.begin(), cpus.end(), id, [](const cpu_t& cpu, uint32_t id) { return cpu.id < id; });
+    if (it == cpus.end() || it->id != id)
+        return nullptr;
+    return &*it;
+}
+
+uint32_t cpu_topology::nodes() const noexcept {
+    return node_count;
+}
+
+cpu_set_t cpu_topology::of_node(uint32_t node) const noexcept {
+    cpu_set_t result{};
+    CPU_ZERO(&result);
+    for (const cpu_t& cpu : cpus)
+        if (cpu.node == node)
+            CPU_SET(cpu.id, &result);
+    return result;
+}
+
+cpu_set_t cpu_topology::of_package(uint32_t package) const noexcept {
+    cpu_set_t result{};
+    CPU_ZERO(&result);
+    for (const cpu_t& cpu : cpus)
+        if (cpu.package == package)
+            CPU_SET(cpu.id, &result);
+    return result;
+}
+
+cpu_set_t cpu_topology::of_core(uint32_t id) const noexcept {
+    cpu_set_t result{};
+    CPU_ZERO(&result);
+    const cpu_t* target = find(id);
+    if (target == nullptr)
+        return result;
+    for (const cpu_t& cpu : cpus)
+        if (cpu.package == target->package && cpu.core == target->core)
+            CPU_SET(cpu.id, &result);
+    return result;
+}
+
+continue_on_cpu::continue_on_cpu(const cpu_set_t& cpus, int realtime) noexcept(false) : attr{} {
+    if (auto ec = pthread_attr_init(&attr))
+        throw system_error{ec, system_category(), "pthread_attr_init"};
+    int ec = pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &cpus);
+    if (ec == 0 && realtime > 0) {
+        sched_param param{};
+        param.sched_priority = realtime;
+        if ((ec = pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED)) == 0 &&
+            (ec = pthread_attr_setschedpolicy(&attr, SCHED_FIFO)) == 0)
+            ec = pthread_attr_setschedparam(&attr, &param);
+    }
+    if (ec) {
+        pthread_attr_destroy(&attr);
+        throw system_error{ec, system_category(), "pthread_attr_set*"};
+    }
+}
+
+continue_on_cpu::~continue_on_cpu() noexcept {
+    pthread_attr_destroy(&attr);
+}
+
+void continue_on_cpu::await_suspend(coro::coroutine_handle<void> coro) noexcept(false) {
+    // nobody joins. the thread returns to the pool after the resume
+    if (auto ec = pthread_pool::global().spawn(tid, &attr, coro, nullptr))
+        throw system_error{static_cast<int>(ec), system_category(), "pthread_create"};
+}
+
+continue_on_cpu run_on_numa_node(uint32_t node, int realtime) noexcept(false) {
+    const cpu_set_t cpus = cpu_topology::current().of_node(node);
+    if (CPU_COUNT(&cpus) == 0)
+        throw invalid_argument{"no online CPU in the NUMA node"};
+    return continue_on_cpu{cpus, realtime};
+}
+
+void* huge_page_source::allocate(size_t length) noexcept(false) {
+    length = (length + page_size - 1) & ~(page_size - 1);
+    void* ptr = MAP_FAILED;
+    uint32_t kind = 0;
+    if (use_hugetlb.load(std::memory_order_relaxed)) {
+        ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (ptr == MAP_FAILED) // no reserved pages. don't try again
+            use_hugetlb.store(false, std::memory_order_relaxed);
+    }
+    if (ptr == MAP_FAILED) {
+        // over-allocate to align the region with the huge page. THP works for the aligned 2MB
+        const size_t extended = length + page_size;
+        auto* raw = static_cast<std::byte*>(
+            mmap(nullptr, extended, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (raw == MAP_FAILED)
+            throw system_error{errno, system_category(), "mmap"};
+        auto* aligned = reinterpret_cast<std::byte*>(
+            (reinterpret_cast<uintptr_t>(raw) + page_size - 1) & ~(uintptr_t{page_size} - 1));
+        if (aligned != raw)
+            munmap(raw, aligned - raw);
+        if (const size_t tail = (raw + extended) - (aligned + length))
+            munmap(aligned + length, tail);
+        ptr = aligned;
+        kind = madvise(ptr, length, MADV_HUGEPAGE) == 0 ? 1 : 2;
+    }
+    unique_lock lck{mtx};
+    regions.emplace(ptr, kind);
+    counters[kind] += length / page_size;
+    return ptr;
+}
+
+void huge_page_source::deallocate(void* ptr, size_t length) noexcept {
+    length = (length + page_size - 1) & ~(page_size - 1);
+    {
+        unique_lock lck{mtx};
+        auto it = regions.find(ptr);
+        if (it == regions.end()) // not from this source. don't unmap the others
+            return;
+        counters[it->second] -= length / page_size;
+        regions.erase(it);
+    }
+    munmap(ptr, length);
+}
+
+huge_page_source::usage_t huge_page_source::usage() noexcept(false) {
+    unique_lock lck{mtx};
+    return usage_t{counters[0], counters[1], counters[2]};
+}
+
+arena_source huge_page_source::source() noexcept {
+    return arena_source{
+        this,
+        [](void* context, size_t length) { return static_cast<huge_page_source*>(context)->allocate(length); },
+        [](void* context, void* ptr, size_t length) {
+            static_cast<huge_page_source*>(context)->deallocate(ptr, length);
+        }};
+}
+
 } // namespace coro
@@ -1,8 +1,16 @@
 /**
  * @author github.com/luncliff (luncliff@gmail.com)
  */
+#include <coroutine/channel_mutex.hpp> // for `internal::park_on`
 #include <coroutine/pthread.h>
 
+#include <climits>
+#include <cstring>
+#include <utility>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
 namespace coro {
 using namespace std;
 
@@ -26,11 +34,30 @@ pthread_joiner::pthread_joiner(promise_type* p) noexcept(false) : promise{p} {
         throw invalid_argument{"nullptr for promise_type*"};
 }
 
+pthread_joiner::pthread_joiner(pthread_joiner&& rhs) noexcept
+    : promise{std::exchange(rhs.promise, nullptr)} {
+}
+
+pthread_joiner& pthread_joiner::operator=(pthread_joiner&& rhs) noexcept {
+    std::swap(promise, rhs.promise); // `rhs` joins the previous one
+    return *this;
+}
+
 pthread_joiner::~pthread_joiner() noexcept(false) {
+    if (promise == nullptr) // moved
+        return;
     pthread_t tid = *this;
     if (tid == pthread_t{}) // spawned no threads. nothing to do
         return;
 
+    if (promise->pooled) {
+        // the thread is parked again after the resume. wait for it instead of join
+        pthread_pool::wait(*promise->completion);
+        auto* p = static_cast<promise_type*>(promise);
+        coro::coroutine_handle<promise_type>::from_promise(*p).destroy();
+        return;
+    }
+
     void* ptr{};
     // we must acquire `tid` before the destruction
     if (auto ec = pthread_join(tid, &ptr)) {
@@ -47,14 +74,201 @@ pthread_detacher::pthread_detacher(promise_type* p) noexcept(false)
         throw invalid_argument{"nullptr for promise_type*"};
 }
 
+pthread_detacher::pthread_detacher(pthread_detacher&& rhs) noexcept
+    : promise{std::exchange(rhs.promise, nullptr)} {
+}
+
+pthread_detacher& pthread_detacher::operator=(pthread_detacher&& rhs) noexcept {
+    std::swap(promise, rhs.promise); // `rhs` detaches the previous one
+    return *this;
+}
+
 pthread_detacher::~pthread_detacher() noexcept(false) {
-    pthread_t tid = *this;
+    if (promise == nullptr) // moved
+        return;
+    auto* p = static_cast<promise_type*>(promise);
+    const pthread_t tid = p->tid;
+    const bool pooled = p->pooled;
+    // the frame is done with its `final_suspend`. the promise is not used from now on
+    if (p->refs.fetch_sub(1, memory_order_acq_rel) == 1)
+        coro::coroutine_handle<promise_type>::from_promise(*p).destroy();
+
     if (tid == pthread_t{}) // spawned no threads. nothing to do
         return;
+    if (pooled) // the thread returns to the pool by itself
+        return;
 
     if (auto ec = pthread_detach(tid)) {
         throw system_error{ec, system_category(), "pthread_join"};
     }
 }
 
+/**
+ * @brief The attributes which make the threads different
+ */
+struct pthread_pool_key_t final {
+    size_t stack_size;
+    size_t guard_size;
+    int inherit;
+    int policy;
+    int priority;
+#if defined(__linux__)
+    cpu_set_t affinity;
+#endif
+
+    explicit pthread_pool_key_t(const pthread_attr_t* attr) noexcept {
+        memset(this, 0, sizeof(pthread_pool_key_t)); // the padding is compared too
+        pthread_attr_t defaults{};
+        if (attr == nullptr) {
+            pthread_attr_init(&defaults);
+            attr = &defaults;
+        }
+        sched_param param{};
+        pthread_attr_getstacksize(attr, &stack_size);
+        pthread_attr_getguardsize(attr, &guard_size);
+        pthread_attr_getinheritsched(attr, &inherit);
+        pthread_attr_getschedpolicy(attr, &policy);
+        pthread_attr_getschedparam(attr, &param);
+        priority = param.sched_priority;
+#if defined(__linux__)
+        pthread_attr_getaffinity_np(attr, sizeof(cpu_set_t), &affinity);
+#endif
+        if (attr == &defaults)
+            pthread_attr_destroy(&defaults);
+    }
+    bool is_realtime() const noexcept {
+        return inherit == PTHREAD_EXPLICIT_SCHED && (policy == SCHED_FIFO || policy == SCHED_RR);
+    }
+    bool operator==(const pthread_pool_key_t& rhs) const noexcept {
+        return memcmp(this, &rhs, sizeof(pthread_pool_key_t)) == 0;
+    }
+};
+
+struct pthread_pool::worker_t final {
+    static constexpr uint32_t parked = 0, ready = 1, retired = 2;
+
+    const pthread_pool_key_t key;
+    pthread_t tid{};
+    std::atomic<uint32_t> state{}; /// futex word
+    void* frame = nullptr;
+    std::atomic<uint32_t>* completion = nullptr;
+
+    explicit worker_t(const pthread_attr_t* attr) noexcept : key{attr} {
+    }
+
+    /// @brief fault in the whole stack and keep it in the memory. best effort (`RLIMIT_MEMLOCK`)
+    static void lock_stack() noexcept {
+#if defined(__linux__)
+        pthread_attr_t attr{};
+        if (pthread_getattr_np(pthread_self(), &attr))
+            return;
+        void* addr = nullptr;
+        size_t len = 0;
+        if (pthread_attr_getstack(&attr, &addr, &len) == 0)
+            mlock(addr, len); // populates the pages too
+        pthread_attr_destroy(&attr);
+#endif
+    }
+
+    static void* on_pthread(void* ptr) noexcept(false) {
+        auto* w = static_cast<worker_t*>(ptr);
+        if (w->key.is_realtime())
+            lock_stack();
+        do {
+            uint32_t state = parked;
+            while ((state = w->state.load(std::memory_order_acquire)) == parked)
+                internal::park_on(w->state, parked);
+            if (state == retired) {
+                // the evicting thread wakes this under the lock. wait for its end before the `delete`
+                unique_lock lck{pthread_pool::global().mtx};
+                break;
+            }
+
+            auto task = coro::coroutine_handle<void>::from_address(w->frame);
+            if (task.done() == false)
+                task.resume();
+            // the `completion` is signaled in the `release`. `w` must not be used after it returns true
+            if (pthread_pool::global().release(w) == false)
+                break;
+        } while (true);
+        delete w;
+        return nullptr;
+    }
+};
+
+pthread_pool::pthread_pool(size_t count) noexcept : limit{count} {
+}
+
+pthread_pool& pthread_pool::global() noexcept(false) {
+    // never destroyed. the pooled threads may access it until the process ends
+    static pthread_pool* pool = new pthread_pool{64};
+    return *pool;
+}
+
+uint32_t pthread_pool::spawn(pthread_t& tid, const pthread_attr_t* attr, coro::coroutine_handle<void> coro,
+                             std::atomic<uint32_t>* completion) noexcept(false) {
+    const pthread_pool_key_t key{attr};
+    worker_t* w = nullptr;
+    {
+        unique_lock lck{mtx};
+        for (auto it = idle.rbegin(); it != idle.rend(); ++it) {
+            if ((*it)->key == key) {
+                w = *it;
+                idle.erase(std::next(it).base());
+                break;
+            }
+        }
+        // the pool is full of the other attributes. evict the oldest, so the new thread can be parked after its work
+        if (w == nullptr && idle.empty() == false && idle.size() >= limit) {
+            worker_t* oldest = idle.front();
+            idle.erase(idle.begin());
+            oldest->state.store(worker_t::retired, std::memory_order_release);
+            internal::unpark(oldest->state, 1);
+        }
+    }
+    if (w == nullptr) {
+        w = new worker_t{attr}; // parked until the assignment below
+        if (auto ec = ::pthread_create(&w->tid, attr, worker_t::on_pthread, w)) {
+            delete w;
+            return ec;
+        }
+        // the pool never joins. the joiner/detacher use `completion`
+        ::pthread_detach(w->tid);
+    }
+    // `tid` can be a part of the coroutine frame. write it before the resume
+    tid = w->tid;
+    w->frame = coro.address();
+    w->completion = completion;
+    w->state.store(worker_t::ready, std::memory_order_release);
+    internal::unpark(w->state, 1);
+    return 0;
+}
+
+bool pthread_pool::release(worker_t* w) noexcept(false) {
+    unique_lock lck{mtx};
+    // the `completion` can be a part of the coroutine frame. the waiter frees it after this unlock
+    if (auto* completion = std::exchange(w->completion, nullptr)) {
+        completion->store(1, std::memory_order_release);
+        internal::unpark(*completion, INT_MAX);
+    }
+    // return to the pool with the signal. so the next `spawn` after the join can reuse this thread
+    if (idle.size() >= limit)
+        return false;
+    w->state.store(worker_t::parked, std::memory_order_relaxed);
+    idle.push_back(w);
+    return true;
+}
+
+size_t pthread_pool::idle_count() noexcept(false) {
+    unique_lock lck{mtx};
+    return idle.size();
+}
+
+void pthread_pool::wait(std::atomic<uint32_t>& completion) noexcept(false) {
+    while (completion.load(std::memory_order_acquire) == 0)
+        internal::park_on(completion, 0);
+    // the worker signals under the lock. after this, it never touches the `completion`
+    unique_lock lck{global().mtx};
+}
+
 } // namespace coro
@@ -0,0 +1,197 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ */
+#undef NDEBUG
+#include <atomic>
+#include <cassert>
+#include <stdexcept>
+#include <thread>
+
+#include <coroutine/async_scope.hpp>
+#include <coroutine/return.h>
+#include <coroutine/task.hpp>
+#include <coroutine/thread_pool.hpp>
+
+using namespace std;
+using namespace coro;
+
+void wait_for(const atomic<bool>& flag) {
+    while (flag.load() == false)
+        this_thread::yield();
+}
+
+#if defined(__GNUC__)
+using no_return_t = coro::null_frame_t;
+#else
+using no_return_t = std::nullptr_t;
+#endif
+
+auto increase(thread_pool& pool, atomic<uint32_t>& counter) -> task<void> {
+    co_await pool.schedule();
+    counter.fetch_add(1);
+}
+
+auto spin_until_cancel(thread_pool& pool, async_scope& scope, atomic<uint32_t>& loops) -> task<void> {
+    while (scope.is_cancelled() == false) {
+        co_await pool.schedule(); // re-submit. let the others run
+        loops.fetch_add(1);
+    }
+}
+
+auto fail(thread_pool& pool) -> task<void> {
+    co_await pool.schedule();
+    throw runtime_error{"async_scope"};
+}
+
+auto run_and_join(thread_pool& pool, atomic<uint32_t>& counter, atomic<bool>& done) -> no_return_t {
+    async_scope scope{};
+    for (uint32_t i = 0; i < 1000; ++i)
+        scope.spawn(increase(pool, counter));
+    co_await scope.join(); // suspend. no thread is blocked
+    assert(counter == 1000);
+    assert(scope.size() == 0);
+
+    // reuse after the join
+    for (uint32_t i = 0; i < 10; ++i)
+        scope.spawn(increase(pool, counter));
+    co_await scope.join();
+    assert(counter == 1010);
+    done = true;
+}
+
+auto cancel_and_join(thread_pool& pool, atomic<uint32_t>& loops, atomic<bool>& done) -> no_return_t {
+    async_scope scope{};
+    for (uint32_t i = 0; i < 4; ++i)
+        scope.spawn(spin_until_cancel(pool, scope, loops));
+    while (loops.load() < 100)
+        co_await pool.schedule();
+    scope.cancel();
+    assert(scope.spawn(spin_until_cancel(pool, scope, loops)) == false); // ignored after the cancel
+    co_await scope.join();
+    done = true;
+}
+
+auto join_error(thread_pool& pool, atomic<bool>& caught, atomic<bool>& done) -> no_return_t {
+    async_scope scope{};
+    atomic<uint32_t> counter{};
+    scope.spawn(increase(pool, counter));
+    scope.spawn(fail(pool));
+    scope.spawn(fail(pool));
+    try {
+        co_await scope.join();
+    } catch (const runtime_error&) {
+        caught = true;
+    }
+    assert(counter == 1);
+    done = true;
+}
+
+auto spawn_sibling(thread_pool& pool, async_scope& scope, atomic<uint32_t>& counter) -> task<void> {
+    co_await pool.schedule();
+    assert(scope.spawn(increase(pool, counter))); // this child is running. joined together
+    counter.fetch_add(1);
+}
+
+auto join_with_sibling(thread_pool& pool, atomic<uint32_t>& counter, atomic<bool>& done) -> no_return_t {
+    async_scope scope{};
+    for (uint32_t i = 0; i < 100; ++i)
+        scope.spawn(spawn_sibling(pool, scope, counter));
+    co_await scope.join();
+    assert(counter == 200);
+    done = true;
+}
+
+/// @brief `spawn` from the other thread while the join ends and restarts
+auto join_repeatedly(async_scope& scope, uint32_t count, atomic<bool>& done) -> no_return_t {
+    for (uint32_t i = 0; i < count; ++i)
+        co_await scope.join();
+    done = true;
+}
+
+void spawn_while_joining(thread_pool& pool) {
+    async_scope scope{};
+    atomic<uint32_t> counter{};
+    atomic<bool> stop{};
+    uint32_t spawned = 0;
+    thread spawner{[&]() {
+        while (stop == false)
+            if (scope.spawn(increase(pool, counter)))
+                ++spawned;
+    }};
+    atomic<bool> done{};
+    join_repeatedly(scope, 1000, done);
+    wait_for(done);
+    stop = true;
+    spawner.join();
+
+    done = false;
+    join_repeatedly(scope, 1, done); // no more spawn. all of them are joined
+    wait_for(done);
+    assert(counter == spawned);
+}
+
+void spawn_after_last_child() {
+    async_scope scope{};
+    auto join = scope.join();
+    assert(join.await_ready()); // no child. the join is done
+    assert(scope.spawn(suspend_never{}) == false);
+    join.await_resume();
+    assert(scope.spawn(suspend_never{})); // the next join can count it
+    assert(scope.size() == 0);
+}
+
+/// @brief the child can't start with this. `spawn` throws
+struct throw_on_move_t final : suspend_never {
+    throw_on_move_t() noexcept = default;
+    throw_on_move_t(throw_on_move_t&&) noexcept(false) {
+        throw runtime_error{"move"};
+    }
+};
+
+void spawn_failure_is_not_counted() {
+    async_scope scope{};
+    try {
+        scope.spawn(throw_on_move_t{});
+        assert(false);
+    } catch (const runtime_error&) {
+    }
+    assert(scope.size() == 0);
+    assert(scope.join().await_ready()); // not waiting for the child which didn't start
+}
+
+int main(int, char*[]) {
+    thread_pool pool{4};
+    {
+        atomic<uint32_t> counter{};
+        atomic<bool> done{};
+        run_and_join(pool, counter, done);
+        wait_for(done);
+    }
+    {
+        atomic<uint32_t> loops{};
+        atomic<bool> done{};
+        cancel_and_join(pool, loops, done);
+        wait_for(done);
+    }
+    {
+        atomic<bool> caught{}, done{};
+        join_error(pool, caught, done);
+        wait_for(done);
+        assert(caught);
+    }
+    {
+        // nothing spawned. `join` doesn't suspend
+        async_scope scope{};
+        assert(scope.join().await_ready());
+    }
+    {
+        atomic<uint32_t> counter{};
+        atomic<bool> done{};
+        join_with_sibling(pool, counter, done);
+        wait_for(done);
+    }
+    spawn_while_joining(pool);
+    spawn_after_last_child();
+    spawn_failure_is_not_counted();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,88 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ */
+
+#undef NDEBUG
+#include <cassert>
+#include <string>
+
+#include <coroutine/channel.hpp>
+#include <coroutine/return.h>
+
+using namespace std;
+using namespace coro;
+
+#if defined(__GNUC__)
+using no_return_t = coro::null_frame_t;
+#else
+using no_return_t = std::nullptr_t;
+#endif
+
+/// @brief no default constructor, no copy
+struct message_t final {
+    string text;
+    explicit message_t(const char* txt) : text{txt} {
+    }
+    message_t(const message_t&) = delete;
+    message_t(message_t&&) = default;
+    message_t& operator=(message_t&&) = default;
+};
+
+using channel_t = channel<message_t>;
+
+auto write_to(channel_t& ch, message_t msg, bool& ok) -> no_return_t {
+    ok = co_await ch.write(msg);
+}
+
+auto borrow_from(channel_t& ch, channel_borrow<message_t>& ref) -> no_return_t {
+    ref = co_await ch.borrow();
+}
+
+auto read_from(channel_t& ch, optional<message_t>& ref) -> no_return_t {
+    ref = co_await ch.read_optional();
+}
+
+void borrow_keeps_writer_suspended() {
+    channel_t ch{};
+    bool ok = false;
+    channel_borrow<message_t> msg{};
+    write_to(ch, message_t{"hello"}, ok); // writer will suspend
+    borrow_from(ch, msg);
+    assert(msg);
+    assert(msg->text == "hello");
+    assert(ok == false); // the writer is still waiting
+    msg.release();
+    assert(ok); // borrow ended. the writer is resumed
+    assert(!msg);
+}
+
+void borrow_from_waiting_reader() {
+    channel_t ch{};
+    bool ok = false;
+    channel_borrow<message_t> msg{};
+    borrow_from(ch, msg); // reader will suspend
+    assert(!msg);
+    write_to(ch, message_t{"world"}, ok);
+    assert(msg && msg->text == "world");
+    assert(ok == false);
+    msg = channel_borrow<message_t>{}; // assignment ends the borrow
+    assert(ok);
+}
+
+void read_without_default_constructor() {
+    channel_t ch{};
+    bool ok = false;
+    optional<message_t> msg{};
+    read_from(ch, msg);
+    assert(msg.has_value() == false);
+    write_to(ch, message_t{"in place"}, ok);
+    assert(ok);
+    assert(msg.has_value() && msg->text == "in place");
+}
+
+int main(int, char*[]) {
+    borrow_keeps_writer_suspended();
+    borrow_from_waiting_reader();
+    read_without_default_constructor();
+    return EXIT_SUCCESS;
+}
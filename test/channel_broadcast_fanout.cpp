@@ -0,0 +1,121 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ */
+
+#undef NDEBUG
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+#include <coroutine/channel_broadcast.hpp>
+#include <coroutine/return.h>
+
+using namespace std;
+using namespace coro;
+
+using channel_t = broadcast_channel<int>;
+using subscriber_t = broadcast_subscriber<int, bypass_mutex>;
+#if defined(__GNUC__)
+using no_return_t = coro::null_frame_t;
+#else
+using no_return_t = std::nullptr_t;
+#endif
+
+auto write_to(channel_t& ch, int value, bool& ok) -> no_return_t {
+    ok = co_await ch.write(value);
+}
+
+auto read_from(subscriber_t& sub, shared_ptr<const int>& ref, bool& ok) -> no_return_t {
+    tie(ref, ok) = co_await sub.read();
+}
+
+void fanout_to_all_subscribers() {
+    channel_t ch{4};
+    subscriber_t s1{ch}, s2{ch};
+    shared_ptr<const int> v1{}, v2{};
+    bool r1 = false, r2 = false, w = false;
+
+    read_from(s1, v1, r1); // readers will suspend
+    read_from(s2, v2, r2);
+    assert(v1 == nullptr && v2 == nullptr);
+
+    write_to(ch, 7, w); // 1 write resumes both of them
+    assert(w && r1 && r2);
+    assert(*v1 == 7);
+    assert(v1 == v2); // not a copy. they share the value
+}
+
+void backpressure_waits_for_slowest() {
+    channel_t ch{2, broadcast_policy::backpressure};
+    subscriber_t sub{ch};
+    bool w1 = false, w2 = false, w3 = false;
+    write_to(ch, 1, w1);
+    write_to(ch, 2, w2);
+    write_to(ch, 3, w3); // the ring is full. wait for the subscriber
+    assert(w1 && w2);
+    assert(w3 == false);
+
+    shared_ptr<const int> value{};
+    bool ok = false;
+    read_from(sub, value, ok); // release the oldest. the writer can continue
+    assert(ok && *value == 1);
+    assert(w3);
+    read_from(sub, value, ok);
+    assert(ok && *value == 2);
+    read_from(sub, value, ok);
+    assert(ok && *value == 3);
+}
+
+void drop_oldest_counts_lag() {
+    channel_t ch{2, broadcast_policy::drop_oldest};
+    subscriber_t sub{ch};
+    for (int i = 1; i <= 5; ++i) {
+        bool ok = false;
+        write_to(ch, i, ok); // never waits
+        assert(ok);
+    }
+    shared_ptr<const int> value{};
+    bool ok = false;
+    read_from(sub, value, ok);
+    assert(ok && *value == 4); // 1, 2, 3 are dropped
+    assert(sub.lag() == 3);
+}
+
+auto listen(broadcast_channel<int, mutex>& ch, bool& closed) -> no_return_t {
+    broadcast_subscriber<int, mutex> sub{ch}; // destroyed while the channel is closing
+    while (true) {
+        auto [value, ok] = co_await sub.read();
+        if (ok == false)
+            break;
+    }
+    closed = true;
+}
+
+void destroy_with_listening_subscriber() {
+    bool closed = false;
+    {
+        broadcast_channel<int, mutex> ch{2};
+        listen(ch, closed);
+        assert(closed == false);
+    } // the listener ends and unsubscribes in the channel's destructor
+    assert(closed);
+}
+
+void reject_zero_capacity() {
+    try {
+        channel_t ch{0};
+    } catch (const invalid_argument&) {
+        return;
+    }
+    assert(false);
+}
+
+int main(int, char*[]) {
+    fanout_to_all_subscribers();
+    backpressure_waits_for_slowest();
+    drop_oldest_counts_lag();
+    destroy_with_listening_subscriber();
+    reject_zero_capacity();
+    return EXIT_SUCCESS;
+}
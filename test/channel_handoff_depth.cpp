@@ -0,0 +1,67 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ */
+
+#undef NDEBUG
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+
+#include <coroutine/channel.hpp>
+#include <coroutine/return.h>
+
+using namespace std;
+using namespace coro;
+
+using channel_without_lock_t = channel<int>;
+#if defined(__GNUC__)
+using no_return_t = coro::null_frame_t;
+#else
+using no_return_t = std::nullptr_t;
+#endif
+
+uintptr_t bottom = 0, deepest = 0;
+
+// coroutine's local variables can be in the frame. use a subroutine's one
+void update_deepest() noexcept {
+    volatile int marker = 0; // the stack grows downward in the known platforms
+    deepest = min(deepest, reinterpret_cast<uintptr_t>(&marker));
+}
+
+// read from `src` and write the increased value to `dst`
+auto relay(channel_without_lock_t& src, channel_without_lock_t& dst) -> no_return_t {
+    auto [value, ok] = co_await src.read();
+    assert(ok);
+    update_deepest();
+    value += 1;
+    ok = co_await dst.write(value);
+    assert(ok);
+}
+
+auto read_from(channel_without_lock_t& ch, int& ref, bool ok = false) -> no_return_t {
+    tie(ref, ok) = co_await ch.read();
+    assert(ok);
+}
+
+auto write_to(channel_without_lock_t& ch, int value, bool ok = false) -> no_return_t {
+    ok = co_await ch.write(value);
+    assert(ok);
+}
+
+int main(int, char*[]) {
+    // with nested `resume`, the stack depth grows with the length of the chain
+    constexpr size_t length = 200'000;
+    auto channels = make_unique<channel_without_lock_t[]>(length + 1);
+    for (size_t i = 0; i < length; ++i)
+        relay(channels[i], channels[i + 1]); // all relays are waiting for read
+
+    int result = 0;
+    bottom = deepest = reinterpret_cast<uintptr_t>(&result);
+    read_from(channels[length], result); // wait at the end of the chain
+    write_to(channels[0], 1);            // must be delivered before return
+    assert(result == length + 1);
+    // the relays are resumed by the trampoline, not by each other
+    assert(bottom - deepest < 64 * 1024);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,112 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ * @brief  The lockables for `channel`. Each one runs the same workloads
+ */
+
+#undef NDEBUG
+#include <atomic>
+#include <cassert>
+#include <thread>
+#include <vector>
+
+#include <coroutine/channel.hpp>
+#include <coroutine/channel_mutex.hpp>
+#include <coroutine/return.h>
+
+using namespace std;
+using namespace coro;
+
+#if defined(__GNUC__)
+using no_return_t = coro::null_frame_t;
+#else
+using no_return_t = std::nullptr_t;
+#endif
+
+template <typename M>
+auto write_to(channel<uint64_t, M>& ch, uint64_t value, atomic<uint64_t>& sent) -> no_return_t {
+    bool ok = co_await ch.write(value);
+    if (ok)
+        sent += value;
+}
+
+template <typename M>
+auto read_from(channel<uint64_t, M>& ch, atomic<uint64_t>& received, atomic<uint32_t>& done) -> no_return_t {
+    auto [value, ok] = co_await ch.read();
+    if (ok)
+        received += value;
+    ++done;
+}
+
+/// @brief the lockable must be exclusive
+template <typename M>
+void exclusive(uint32_t num_thread, uint32_t count) {
+    M mtx{};
+    uint64_t counter = 0;
+    vector<thread> threads{};
+    for (uint32_t t = 0; t < num_thread; ++t)
+        threads.emplace_back([&]() {
+            for (uint32_t i = 0; i < count; ++i) {
+                std::unique_lock lck{mtx};
+                ++counter;
+            }
+        });
+    for (auto& t : threads)
+        t.join();
+    assert(counter == uint64_t{num_thread} * count);
+}
+
+/// @brief 1 thread. read/write in turn. the cost of the uncontended lock
+template <typename M>
+void ping_pong(uint32_t count) {
+    channel<uint64_t, M> ch{};
+    atomic<uint64_t> sent{}, received{};
+    atomic<uint32_t> done{};
+    for (uint32_t i = 1; i <= count; ++i) {
+        read_from(ch, received, done);
+        write_to(ch, i, sent);
+    }
+    assert(done == count);
+    assert(sent == received);
+}
+
+/// @brief N writer threads and N reader threads on a channel
+template <typename M>
+void many_to_many(uint32_t num_thread, uint32_t count) {
+    channel<uint64_t, M> ch{};
+    atomic<uint64_t> sent{}, received{};
+    atomic<uint32_t> done{};
+    vector<thread> threads{};
+    for (uint32_t t = 0; t < num_thread; ++t) {
+        threads.emplace_back([&]() {
+            for (uint32_t i = 1; i <= count; ++i)
+                write_to(ch, i, sent);
+        });
+        threads.emplace_back([&]() {
+            for (uint32_t i = 0; i < count; ++i)
+                read_from(ch, received, done);
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+    while (done < num_thread * count) // the last readers can be resumed in the other thread
+        this_thread::yield();
+    assert(sent == received);
+}
+
+int main(int, char*[]) {
+    const uint32_t num_thread = max(2u, thread::hardware_concurrency() / 2);
+    constexpr uint32_t count = 10'000;
+
+    exclusive<adaptive_mutex>(num_thread, count);
+    exclusive<ticket_mutex>(num_thread, count);
+
+    ping_pong<bypass_mutex>(count);
+    ping_pong<std::mutex>(count);
+    ping_pong<adaptive_mutex>(count);
+    ping_pong<ticket_mutex>(count);
+
+    many_to_many<std::mutex>(num_thread, count);
+    many_to_many<adaptive_mutex>(num_thread, count);
+    many_to_many<ticket_mutex>(num_thread, count);
+    return EXIT_SUCCESS;
+}
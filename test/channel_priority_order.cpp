@@ -0,0 +1,99 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ */
+
+#undef NDEBUG
+#include <cassert>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <coroutine/channel_priority.hpp>
+#include <coroutine/return.h>
+
+using namespace std;
+using namespace coro;
+
+using channel_t = priority_channel<int, bypass_mutex, 4>;
+#if defined(__GNUC__)
+using no_return_t = coro::null_frame_t;
+#else
+using no_return_t = std::nullptr_t;
+#endif
+
+auto write_to(channel_t& ch, int value, uint32_t level) -> no_return_t {
+    auto ok = co_await ch.write(value, level);
+    assert(ok);
+}
+
+auto read_from(channel_t& ch, int& ref, bool ok = false) -> no_return_t {
+    tie(ref, ok) = co_await ch.read();
+    assert(ok);
+}
+
+void highest_level_first() {
+    channel_t ch{};
+    write_to(ch, 1, 0); // writers will suspend
+    write_to(ch, 2, 0);
+    write_to(ch, 3, 3);
+    write_to(ch, 4, 1);
+    write_to(ch, 5, 3);
+
+    vector<int> received{};
+    for (auto i = 0; i < 5; ++i) {
+        int value = 0;
+        read_from(ch, value);
+        received.push_back(value);
+    }
+    // higher level first. FIFO in the same level
+    assert((received == vector<int>{3, 5, 4, 1, 2}));
+}
+
+// keep 1 high priority writer in the channel, then count reads until the low one is delivered
+size_t count_reads_for_low_priority(uint64_t aging) {
+    channel_t ch{aging};
+    constexpr int low = -1;
+    write_to(ch, low, 0);
+    write_to(ch, 0, 3);
+    for (size_t count = 1; count < 100; ++count) {
+        int value = 0;
+        read_from(ch, value);
+        if (value == low) {
+            read_from(ch, value); // take the high one to clear the channel
+            return count;
+        }
+        write_to(ch, static_cast<int>(count), 3); // the control plane is busy ...
+    }
+    int value = 0;
+    read_from(ch, value); // take the high one and the starved one to clear the channel
+    read_from(ch, value);
+    assert(value == low);
+    return SIZE_MAX;
+}
+
+using locked_channel_t = priority_channel<int, mutex, 2>;
+
+/// @brief retry once after the channel's close. it locks the channel in its destructor
+auto write_twice(locked_channel_t& ch, int value, uint32_t& closed) -> no_return_t {
+    for (auto i = 0; i < 2; ++i)
+        if (co_await ch.write(value, 1) == false)
+            ++closed;
+}
+
+void destroy_with_retrying_writer() {
+    uint32_t closed = 0;
+    {
+        locked_channel_t ch{};
+        write_twice(ch, 7, closed);
+        assert(closed == 0);
+    }
+    assert(closed == 2);
+}
+
+int main(int, char*[]) {
+    highest_level_first();
+    assert(count_reads_for_low_priority(0) == SIZE_MAX); // starved
+    assert(count_reads_for_low_priority(2) < 10);        // promoted to the top level
+    destroy_with_retrying_writer();
+    return EXIT_SUCCESS;
+}
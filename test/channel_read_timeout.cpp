@@ -0,0 +1,169 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ */
+
+#undef NDEBUG
+#include <atomic>
+#include <cassert>
+#include <thread>
+
+#include <coroutine/channel.hpp>
+#include <coroutine/return.h>
+
+using namespace std;
+using namespace std::chrono;
+using namespace coro;
+
+#if defined(__GNUC__)
+using no_return_t = coro::null_frame_t;
+#else
+using no_return_t = std::nullptr_t;
+#endif
+
+using clock_type = deadline_queue::clock_type;
+
+template <typename M>
+auto write_to(channel<int, M>& ch, int value, clock_type::time_point deadline, deadline_queue& q,
+              channel_status& status) -> no_return_t {
+    status = co_await ch.write_until(value, deadline, q);
+}
+
+template <typename M>
+auto read_from(channel<int, M>& ch, clock_type::time_point deadline, deadline_queue& q, int& value,
+               channel_status& status) -> no_return_t {
+    tie(value, status) = co_await ch.read_until(deadline, q);
+}
+
+auto write_to(channel<int>& ch, int value, bool& ok) -> no_return_t {
+    ok = co_await ch.write(value);
+}
+
+auto read_from(channel<int>& ch, int& value, bool& ok) -> no_return_t {
+    tie(value, ok) = co_await ch.read();
+}
+
+void read_passed_deadline() {
+    deadline_queue q{};
+    channel<int> ch{};
+    int value = 0;
+    auto status = channel_status::success;
+    read_from(ch, clock_type::now() - 1s, q, value, status);
+    // no suspension. the reader is not in the channel
+    assert(status == channel_status::timed_out);
+    assert(q.next().has_value() == false);
+}
+
+void read_timeout_unlinks_reader() {
+    deadline_queue q{};
+    channel<int> ch{};
+    const auto deadline = clock_type::now() + 1h;
+    int value = 0;
+    auto status = channel_status::success;
+    read_from(ch, deadline, q, value, status); // suspends
+    assert(q.next() == deadline);
+    assert(q.poll(deadline - 1s) == 0);
+    assert(q.poll(deadline) == 1);
+    assert(status == channel_status::timed_out);
+    assert(q.next().has_value() == false);
+
+    // the timed out reader must not receive the value
+    bool ok = false;
+    write_to(ch, 7, ok);
+    assert(ok == false);
+    read_from(ch, value, ok);
+    assert(ok && value == 7);
+}
+
+void write_timeout_keeps_value() {
+    deadline_queue q{};
+    channel<int> ch{};
+    const auto deadline = clock_type::now() + 1h;
+    auto status = channel_status::success;
+    write_to(ch, 3, deadline, q, status);
+    assert(q.poll(deadline) == 1);
+    assert(status == channel_status::timed_out);
+
+    int value = 0;
+    read_from(ch, deadline, q, value, status); // no writer in the channel
+    assert(q.poll(deadline) == 1);
+    assert(status == channel_status::timed_out);
+}
+
+void match_before_deadline() {
+    deadline_queue q{};
+    channel<int> ch{};
+    const auto deadline = clock_type::now() + 1h;
+    int value = 0;
+    auto rs = channel_status::timed_out;
+    auto ws = channel_status::timed_out;
+    read_from(ch, deadline, q, value, rs);
+    write_to(ch, 5, deadline, q, ws);
+    assert(rs == channel_status::success && value == 5);
+    assert(ws == channel_status::success);
+    // both are unregistered
+    assert(q.next().has_value() == false);
+    assert(q.poll(deadline) == 0);
+}
+
+void close_before_deadline() {
+    deadline_queue q{};
+    auto status = channel_status::success;
+    {
+        channel<int> ch{};
+        write_to(ch, 1, clock_type::now() + 1h, q, status);
+    }
+    assert(status == channel_status::closed);
+    assert(q.next().has_value() == false);
+}
+
+/// @brief timeouts are racing with the peers. every operation must complete exactly once
+void race_with_peer() {
+    constexpr int count = 20'000;
+    deadline_queue q{};
+    atomic_int pending{2 * count}, delivered{}, expired{};
+    atomic_int64_t sent{}, received{};
+    {
+        channel<int, mutex> ch{};
+
+        auto reader = [&]() -> no_return_t {
+            auto [value, status] = co_await ch.read_until(clock_type::now() + 20us, q);
+            if (status == channel_status::success) {
+                received += value;
+                ++delivered;
+            } else
+                ++expired;
+            --pending;
+        };
+        auto writer = [&](int value) -> no_return_t {
+            auto status = co_await ch.write_until(value, clock_type::now() + 20us, q);
+            if (status == channel_status::success)
+                sent += value;
+            --pending;
+        };
+        thread poller{[&]() {
+            while (pending.load() > 0)
+                q.poll();
+        }};
+        thread producer{[&]() {
+            for (int i = 1; i <= count; ++i)
+                writer(i);
+        }};
+        for (int i = 0; i < count; ++i)
+            reader();
+        producer.join();
+        poller.join();
+    }
+    assert(delivered + expired == count);
+    assert(sent == received);
+    assert(q.next().has_value() == false);
+}
+
+int main(int, char*[]) {
+    read_passed_deadline();
+    read_timeout_unlinks_reader();
+    write_timeout_keeps_value();
+    match_before_deadline();
+    close_before_deadline();
+    race_with_peer();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,53 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ */
+
+#undef NDEBUG
+#include <cassert>
+#include <cstdint>
+#include <thread>
+
+#include <coroutine/channel_spsc.hpp>
+#include <coroutine/return.h>
+
+using namespace std;
+using namespace coro;
+
+using channel_t = spsc_channel<uint64_t, 64>;
+#if defined(__GNUC__)
+using no_return_t = coro::null_frame_t;
+#else
+using no_return_t = std::nullptr_t;
+#endif
+
+constexpr uint64_t count = 1'000'000;
+
+auto produce(channel_t& ch) -> no_return_t {
+    for (uint64_t i = 1; i <= count; ++i) {
+        auto ok = co_await ch.write(i);
+        assert(ok);
+    }
+}
+
+auto consume(channel_t& ch, uint64_t& sum) -> no_return_t {
+    for (uint64_t i = 1; i <= count; ++i) {
+        auto [value, ok] = co_await ch.read();
+        assert(ok);
+        assert(value == i); // FIFO
+        sum += value;
+    }
+}
+
+int main(int, char*[]) {
+    channel_t ch{};
+    uint64_t sum = 0;
+    {
+        // the parked coroutine will be resumed by the other thread
+        thread consumer{[&]() { consume(ch, sum); }};
+        thread producer{[&]() { produce(ch); }};
+        producer.join();
+        consumer.join();
+    }
+    assert(sum == count * (count + 1) / 2);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,93 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ */
+
+#undef NDEBUG
+#include <cassert>
+
+#include <coroutine/channel.hpp>
+#include <coroutine/return.h>
+
+using namespace std;
+using namespace coro;
+
+#if defined(__GNUC__)
+using no_return_t = coro::null_frame_t;
+#else
+using no_return_t = std::nullptr_t;
+#endif
+
+using channel_t = channel<int, instrumented<bypass_mutex>>;
+
+// the counters must not change the layout of the plain channel
+static_assert(sizeof(channel_reader<int, bypass_mutex>) == 3 * sizeof(void*));
+static_assert(sizeof(channel_writer<int, bypass_mutex>) == 3 * sizeof(void*));
+
+auto write_to(channel_t& ch, int value, bool& ok) -> no_return_t {
+    ok = co_await ch.write(value);
+}
+
+auto read_from(channel_t& ch, int& value, bool& ok) -> no_return_t {
+    tie(value, ok) = co_await ch.read();
+}
+
+uint64_t total_waits(const channel_stats& s) {
+    uint64_t sum = 0;
+    for (auto count : s.wait)
+        sum += count;
+    return sum;
+}
+
+void count_writers() {
+    channel_t ch{};
+    bool ok[3]{};
+    for (int i = 0; i < 3; ++i)
+        write_to(ch, i, ok[i]);
+    auto s = ch.stats();
+    assert(s.writers.depth == 3 && s.writers.peak == 3);
+    assert(s.writers.suspended == 3);
+    assert(s.transfers == 0);
+
+    int value = 0;
+    bool rok = false;
+    read_from(ch, value, rok);
+    read_from(ch, value, rok);
+    s = ch.stats();
+    assert(s.writers.depth == 1 && s.writers.peak == 3);
+    assert(s.readers.fast == 2 && s.readers.suspended == 0);
+    assert(s.transfers == 2);
+    assert(total_waits(s) == 2);
+}
+
+void count_readers() {
+    channel_t ch{};
+    int value = 0;
+    bool ok = false, wok = false;
+    read_from(ch, value, ok);
+    auto s = ch.stats();
+    assert(s.readers.depth == 1 && s.readers.suspended == 1);
+
+    write_to(ch, 7, wok);
+    assert(ok && wok && value == 7);
+    s = ch.stats();
+    assert(s.readers.depth == 0 && s.readers.peak == 1);
+    assert(s.writers.fast == 1 && s.writers.suspended == 0);
+    assert(s.transfers == 1);
+    assert(total_waits(s) == 1);
+}
+
+void bucket_boundary() {
+    static_assert(channel_stats::bucket_of(0) == 0);
+    static_assert(channel_stats::bucket_of(1) == 0);
+    static_assert(channel_stats::bucket_of(2) == 1);
+    static_assert(channel_stats::bucket_of(1023) == 9);
+    static_assert(channel_stats::bucket_of(1024) == 10);
+    static_assert(channel_stats::bucket_of(UINT64_MAX) == channel_stats::bucket_count - 1);
+}
+
+int main(int, char*[]) {
+    count_writers();
+    count_readers();
+    bucket_boundary();
+    return EXIT_SUCCESS;
+}
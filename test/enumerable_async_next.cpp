@@ -0,0 +1,137 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ */
+#undef NDEBUG
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <deque>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <coroutine/async_yield.hpp>
+#include <coroutine/return.h>
+#include <coroutine/task.hpp>
+#include <coroutine/thread_pool.hpp>
+
+using namespace std;
+using namespace coro;
+
+#if defined(__GNUC__)
+using no_return_t = coro::null_frame_t;
+#else
+using no_return_t = std::nullptr_t;
+#endif
+
+// the pending "responses". resumed by `main` like a reactor
+deque<coroutine_handle<void>> pending{};
+
+struct fetch_t final {
+    constexpr bool await_ready() const noexcept {
+        return false;
+    }
+    void await_suspend(coroutine_handle<void> coro) noexcept(false) {
+        pending.push_back(coro);
+    }
+    constexpr void await_resume() const noexcept {
+    }
+};
+
+// 3 pages of 4 items. no buffering of the whole response
+auto pages(uint32_t count) -> async_enumerable<uint32_t> {
+    for (uint32_t page = 0; page < count; ++page) {
+        co_await fetch_t{};
+        for (uint32_t i = 0; i < 4; ++i)
+            co_yield page * 4 + i;
+    }
+}
+
+auto sum_of(async_enumerable<uint32_t>& items, uint32_t& sum, bool& done) -> no_return_t {
+    while (true) {
+        uint32_t* item = co_await items.next();
+        if (item == nullptr)
+            break;
+        sum += *item;
+    }
+    done = true;
+}
+
+auto fail_after(uint32_t count) -> async_enumerable<uint32_t> {
+    for (uint32_t i = 0; i < count; ++i)
+        co_yield i;
+    throw runtime_error{"fail_after"};
+}
+
+auto count_until_error(uint32_t& count) -> task<bool> {
+    auto items = fail_after(3);
+    try {
+        while (true) {
+            uint32_t* item = co_await items.next();
+            if (item == nullptr)
+                break;
+            ++count;
+        }
+    } catch (const runtime_error&) {
+        co_return true;
+    }
+    co_return false;
+}
+
+auto drive(task<bool>& t, bool& result) -> no_return_t {
+    result = co_await t;
+}
+
+// the body continues in the worker threads. the consumer follows it
+auto on_workers(thread_pool& pool, uint32_t count) -> async_enumerable<uint32_t> {
+    for (uint32_t i = 0; i < count; ++i) {
+        co_await pool.schedule();
+        co_yield i;
+    }
+}
+
+auto sum_on_workers(thread_pool& pool, atomic<uint32_t>& sum, atomic<bool>& done) -> no_return_t {
+    auto items = on_workers(pool, 100);
+    while (true) {
+        uint32_t* item = co_await items.next();
+        if (item == nullptr)
+            break;
+        sum += *item;
+    }
+    done = true;
+}
+
+int main(int, char*[]) {
+    {
+        auto items = pages(3);
+        uint32_t sum = 0;
+        bool done = false;
+        sum_of(items, sum, done);
+        while (pending.empty() == false) {
+            auto coro = pending.front();
+            pending.pop_front();
+            coro.resume(); // the producer yields to the consumer directly
+        }
+        assert(done);
+        assert(items.is_done());
+        assert(sum == 11 * 12 / 2);
+    }
+    {
+        uint32_t count = 0;
+        bool thrown = false;
+        auto t = count_until_error(count);
+        drive(t, thrown);
+        assert(thrown);
+        assert(count == 3);
+    }
+    {
+        thread_pool pool{2};
+        atomic<uint32_t> sum{};
+        atomic<bool> done{};
+        sum_on_workers(pool, sum, done);
+        while (done == false)
+            this_thread::yield();
+        assert(sum == 99 * 100 / 2);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,67 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ */
+#undef NDEBUG
+#include <cassert>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include <coroutine/yield.hpp>
+
+using namespace std;
+using namespace coro;
+
+using chunked_t = chunked_enumerable<int, 4>;
+
+auto yield_until_zero(int n) -> chunked_t {
+    while (n-- > 0)
+        co_yield n;
+};
+
+auto throw_after(int n) -> chunked_t {
+    for (auto i = 0; i < n; ++i)
+        co_yield i;
+    throw runtime_error{"throw_after"};
+};
+
+vector<size_t> chunk_sizes(chunked_t& g) {
+    vector<size_t> sizes{};
+    for (auto chunk : g.chunks())
+        sizes.push_back(chunk.size());
+    return sizes;
+}
+
+int main(int, char*[]) {
+    {
+        auto g = yield_until_zero(8); // exact multiple of the chunk
+        assert((chunk_sizes(g) == vector<size_t>{4, 4}));
+    }
+    {
+        auto g = yield_until_zero(10); // the last chunk is partial
+        assert((chunk_sizes(g) == vector<size_t>{4, 4, 2}));
+    }
+    {
+        auto g = yield_until_zero(0);
+        assert(chunk_sizes(g).empty());
+        auto e = yield_until_zero(0);
+        assert(e.begin() == e.end());
+    }
+    {
+        auto g = yield_until_zero(10);
+        assert(accumulate(g.begin(), g.end(), 0) == 45); // 0 - 9
+    }
+    {
+        // the exception comes out of the resume for the chunk
+        auto g = throw_after(6);
+        auto it = g.begin(); // the first chunk is full. no exception yet
+        for (auto i = 0; i < 3; ++i)
+            ++it;
+        try {
+            ++it; // resume for the next chunk
+            assert(false);
+        } catch (const runtime_error&) {
+        }
+    }
+    return EXIT_SUCCESS;
+}
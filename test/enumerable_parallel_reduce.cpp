@@ -0,0 +1,88 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ */
+#undef NDEBUG
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <coroutine/parallel.hpp>
+#include <coroutine/thread_pool.hpp>
+#include <coroutine/yield.hpp>
+
+using namespace std;
+using namespace coro;
+
+auto yield_until_zero(int n) -> enumerable<int> {
+    while (n-- > 0)
+        co_yield n;
+};
+
+auto lines(uint32_t count) -> enumerable<string> {
+    for (uint32_t i = 0; i < count; ++i)
+        co_yield "line " + to_string(i);
+}
+
+auto fail_at(int n) -> enumerable<int> {
+    for (int i = 0; i < n; ++i)
+        co_yield i;
+    throw runtime_error{"fail_at"};
+}
+
+int main(int, char*[]) {
+    thread_pool pool{4};
+
+    // same with `std::accumulate` in enumerable_accumulate.cpp
+    {
+        auto g = yield_until_zero(10);
+        assert(parallel_reduce(pool, g, 0u, plus<>{}, 3) == 45);
+        assert(parallel_reduce(pool, yield_until_zero(0), 7u) == 7);
+    }
+    // ordered reassembly
+    {
+        vector<size_t> lengths{};
+        parallel_transform(
+            pool, lines(1000), [](const string& line) { return line.size(); },
+            [&lengths](size_t length) { lengths.push_back(length); }, 16);
+        assert(lengths.size() == 1000);
+        for (size_t i = 0; i < lengths.size(); ++i)
+            assert(lengths[i] == 5 + to_string(i).size());
+
+        // associative, not commutative. the batches are combined in order
+        const string joined = parallel_reduce(pool, lines(100), string{}, plus<>{}, 7);
+        string expected{};
+        for (auto& line : lines(100))
+            expected += line;
+        assert(joined == expected);
+    }
+    // for_each. no order
+    {
+        atomic<uint64_t> sum{};
+        parallel_for_each(pool, yield_until_zero(10'000), [&sum](int v) { sum += v; }, 100);
+        assert(sum == 9'999ULL * 10'000 / 2);
+    }
+    // exceptions from the source and the work
+    {
+        try {
+            parallel_for_each(pool, fail_at(1000), [](int) {}, 10);
+            return __LINE__;
+        } catch (const runtime_error&) {
+        }
+        try {
+            parallel_for_each(
+                pool, yield_until_zero(1000),
+                [](int v) {
+                    if (v == 500)
+                        throw invalid_argument{"500"};
+                },
+                10);
+            return __LINE__;
+        } catch (const invalid_argument&) {
+        }
+    }
+    return EXIT_SUCCESS;
+}
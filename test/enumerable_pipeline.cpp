@@ -0,0 +1,60 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ */
+#undef NDEBUG
+#include <cassert>
+#include <string>
+#include <vector>
+
+#include <coroutine/pipeline.hpp>
+#include <coroutine/yield.hpp>
+
+using namespace std;
+using namespace coro;
+
+auto iota(uint32_t count, uint32_t& resumes) -> enumerable<uint32_t> {
+    for (uint32_t i = 0; i < count; ++i) {
+        ++resumes;
+        co_yield i;
+    }
+}
+
+auto iota(uint32_t count) -> enumerable<uint32_t> {
+    for (uint32_t i = 0; i < count; ++i)
+        co_yield i;
+}
+
+int main(int, char*[]) {
+    const auto is_even = [](uint32_t v) { return v % 2 == 0; };
+    const auto square = [](uint32_t v) { return uint64_t{v} * v; };
+    {
+        uint32_t resumes = 0;
+        vector<uint64_t> values{};
+        for (uint64_t v : iota(100, resumes) | filter(is_even) | transform(square) | take(4))
+            values.push_back(v);
+        assert((values == vector<uint64_t>{0, 4, 16, 36}));
+        assert(resumes == 7); // 0 ... 6. no resume after the last one
+    }
+    {
+        const vector<string> names{"a", "b", "c"};
+        auto g = iota(10);
+        vector<string> values{};
+        for (auto [i, name] : g | zip(names)) // ends with the shorter one
+            values.push_back(name + to_string(i));
+        assert((values == vector<string>{"a0", "b1", "c2"}));
+    }
+    {
+        uint32_t resumes = 0;
+        for (auto v : iota(10, resumes) | take(0))
+            (void)v;
+        assert(resumes == 0);
+    }
+    {
+        // zip of 2 generators. both are owned by the view
+        uint64_t sum = 0;
+        for (auto [a, b] : iota(5) | zip(iota(3) | transform(square)))
+            sum += a * b;
+        assert(sum == 0 * 0 + 1 * 1 + 2 * 4);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,74 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ */
+#undef NDEBUG
+#include <cassert>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+#include <coroutine/yield.hpp>
+
+using namespace std;
+using namespace coro;
+
+struct node_t final {
+    int value;
+    vector<node_t> children;
+};
+
+auto walk(const node_t& node) -> recursive_enumerable<const int> {
+    co_yield node.value;
+    for (const node_t& child : node.children)
+        co_yield elements_of(walk(child));
+}
+
+// depth-first. one element per level
+auto chain(uint32_t depth, uint32_t& resumes) -> recursive_enumerable<uint32_t> {
+    co_yield depth;
+    ++resumes;
+    if (depth > 0)
+        co_yield elements_of(chain(depth - 1, resumes));
+    ++resumes;
+}
+
+auto nothing() -> recursive_enumerable<int> {
+    co_return;
+}
+
+auto fail_at(int value) -> recursive_enumerable<int> {
+    co_yield value;
+    throw runtime_error{"fail_at"};
+}
+
+auto with_failure() -> recursive_enumerable<int> {
+    co_yield elements_of(nothing());
+    co_yield 1;
+    co_yield elements_of(fail_at(2));
+    co_yield 3; // not reached
+}
+
+int main(int, char*[]) {
+    const node_t tree{1, {{2, {{3, {}}, {4, {}}}}, {5, {}}, {6, {{7, {{8, {}}}}}}}};
+    vector<int> values{};
+    for (int v : walk(tree))
+        values.push_back(v);
+    assert((values == vector<int>{1, 2, 3, 4, 5, 6, 7, 8}));
+
+    // each level is resumed only for its own elements. O(depth) in total, not O(depth^2)
+    constexpr uint32_t depth = 10'000;
+    uint32_t resumes = 0, expected = depth;
+    for (uint32_t v : chain(depth, resumes))
+        assert(v == expected--);
+    assert(resumes == 2 * (depth + 1));
+
+    values.clear();
+    try {
+        for (int v : with_failure())
+            values.push_back(v);
+        return __LINE__;
+    } catch (const runtime_error&) {
+    }
+    assert((values == vector<int>{1, 2}));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,88 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ */
+#undef NDEBUG
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+#include <coroutine/frame_arena.hpp>
+#include <coroutine/return.h>
+#include <coroutine/task.hpp>
+
+using namespace std;
+using namespace coro;
+
+#if defined(__GNUC__)
+using no_return_t = coro::null_frame_t;
+#else
+using no_return_t = std::nullptr_t;
+#endif
+
+atomic<size_t> allocations{};
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1);
+    if (void* ptr = malloc(size))
+        return ptr;
+    throw bad_alloc{};
+}
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+auto leaf(allocator_arg_t, frame_arena&, int value) -> task<int> {
+    co_return value * 2;
+}
+
+auto node(allocator_arg_t, frame_arena& arena, int value) -> task<int> {
+    const int lhs = co_await leaf(allocator_arg, arena, value);
+    const int rhs = co_await leaf(allocator_arg, arena, value + 1);
+    co_return lhs + rhs;
+}
+
+// the arena can be any parameter
+auto request(frame_arena& arena, int& result) -> task<void> {
+    int sum = 0;
+    for (int i = 0; i < 10; ++i)
+        sum += co_await node(allocator_arg, arena, i);
+    result = sum;
+}
+
+auto serve(frame_arena& arena, int& result) -> no_return_t {
+    co_await request(arena, result);
+}
+
+auto without_arena() -> task<int> {
+    co_return 1;
+}
+
+auto use_heap(int& result) -> no_return_t {
+    result = co_await without_arena();
+}
+
+int main(int, char*[]) {
+    frame_arena arena{4096};
+    int result = 0;
+    serve(arena, result); // warm up. the first chunk
+    assert(result == 200);
+    assert(arena.live_frames() == 0);
+    assert(arena.bytes_used() > 0);
+    arena.release();
+
+    const size_t before = allocations.load();
+    serve(arena, result);
+    // 1 chunk for 31 task frames, and the frame of `serve`(not from the arena)
+    assert(allocations.load() - before <= 2);
+    assert(arena.live_frames() == 0);
+    arena.release();
+
+    use_heap(result);
+    assert(result == 1);
+    return EXIT_SUCCESS;
+}
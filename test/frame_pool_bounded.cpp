@@ -0,0 +1,92 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ */
+#undef NDEBUG
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <coroutine/frame_pool.hpp>
+#include <coroutine/return.h>
+
+using namespace std;
+using namespace coro;
+
+struct park_t final {
+    vector<coroutine_handle<void>>& parked;
+
+    constexpr bool await_ready() const noexcept {
+        return false;
+    }
+    void await_suspend(coroutine_handle<void> coro) noexcept(false) {
+        parked.push_back(coro);
+    }
+    constexpr void await_resume() const noexcept {
+    }
+};
+
+auto handler(frame_pool&, vector<coroutine_handle<void>>& parked, atomic<uint32_t>& done) -> bounded_frame_t {
+    co_await park_t{parked};
+    done.fetch_add(1);
+}
+
+auto without_pool(atomic<uint32_t>& done) -> bounded_frame_t {
+    done.fetch_add(1);
+    co_return;
+}
+
+void on_exhausted(void* context, frame_pool&) noexcept {
+    static_cast<atomic<uint32_t>*>(context)->fetch_add(1);
+}
+
+int main(int, char*[]) {
+    frame_pool pool{512, 4};
+    atomic<uint32_t> exhausted{};
+    pool.set_exhausted_hook(&on_exhausted, &exhausted);
+
+    vector<coroutine_handle<void>> parked{};
+    atomic<uint32_t> done{};
+    uint32_t started = 0;
+    for (int i = 0; i < 6; ++i)
+        if (handler(pool, parked, done))
+            ++started;
+    // the 5th and 6th are rejected. no allocation beyond the pool
+    assert(started == 4);
+    assert(parked.size() == 4);
+    assert(pool.size() == 4);
+    assert(pool.rejected() == 2);
+    assert(exhausted == 2);
+
+    // the frame returns to the pool at the end
+    parked.back().resume();
+    parked.pop_back();
+    assert(done == 1);
+    assert(pool.size() == 3);
+    assert(handler(pool, parked, done));
+    assert(pool.size() == 4);
+
+    // the frames can end in the other threads
+    for (int round = 0; round < 100; ++round) {
+        vector<coroutine_handle<void>> resuming{};
+        resuming.swap(parked);
+        thread worker{[&resuming]() {
+            for (auto coro : resuming)
+                coro.resume();
+        }};
+        for (int i = 0; i < 4;)
+            if (handler(pool, parked, done)) // wait until the worker releases some
+                ++i;
+        worker.join();
+    }
+    for (auto coro : parked)
+        coro.resume();
+    assert(pool.size() == 0);
+    assert(done == 5 + 100 * 4);
+
+    assert(without_pool(done));
+    assert(done == 5 + 100 * 4 + 1);
+    return EXIT_SUCCESS;
+}
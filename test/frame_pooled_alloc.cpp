@@ -0,0 +1,83 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ */
+#undef NDEBUG
+#include <cassert>
+#include <thread>
+#include <vector>
+
+#include <coroutine/frame_allocator.hpp>
+#include <coroutine/return.h>
+
+using namespace std;
+using namespace coro;
+
+/// @brief `frame_t` with the thread-local pool. The promise type opts in with the mixin
+class pooled_frame_t : public coroutine_handle<void> {
+  public:
+    class promise_type : public promise_na, public pooled_frame {
+      public:
+        void unhandled_exception() noexcept(false) {
+            throw;
+        }
+        void return_void() noexcept {
+        }
+        pooled_frame_t get_return_object() noexcept {
+            return pooled_frame_t{coroutine_handle<promise_type>::from_promise(*this)};
+        }
+    };
+
+  public:
+    explicit pooled_frame_t(coroutine_handle<void> frame = nullptr) noexcept : coroutine_handle<void>{frame} {
+    }
+};
+
+auto suspend_once(int& value) -> pooled_frame_t {
+    co_await suspend_always{};
+    ++value;
+}
+
+int main(int, char*[]) {
+    int value = 0;
+    {
+        // same thread. the frame is reused
+        for (int i = 0; i < 1000; ++i) {
+            auto frame = suspend_once(value);
+            frame.resume();
+            frame.destroy();
+        }
+        assert(value == 1000);
+        const frame_stats s = pooled_frame::stats();
+        assert(s.misses == 1);
+        assert(s.hits == 999);
+        assert(s.hit_rate() > 0.99);
+        assert(s.sizes[frame_stats::class_count] == 0); // small frame
+    }
+    {
+        // destroyed in the other thread. returned with the remote stack
+        vector<pooled_frame_t> frames{};
+        for (int i = 0; i < 100; ++i)
+            frames.emplace_back(suspend_once(value));
+        thread{[&frames]() {
+            for (auto& frame : frames)
+                frame.destroy();
+            assert(pooled_frame::stats().remote_frees == 100);
+        }}.join();
+        const frame_stats before = pooled_frame::stats();
+        for (int i = 0; i < 100; ++i)
+            suspend_once(value).destroy();
+        const frame_stats after = pooled_frame::stats();
+        assert(after.misses == before.misses); // all reclaimed
+    }
+    {
+        // the owner thread exits before the frames are destroyed
+        vector<pooled_frame_t> frames{};
+        thread{[&frames, &value]() {
+            for (int i = 0; i < 10; ++i)
+                frames.emplace_back(suspend_once(value));
+        }}.join();
+        for (auto& frame : frames)
+            frame.destroy();
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,82 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ */
+#undef NDEBUG
+#include <atomic>
+#include <cassert>
+#include <sched.h>
+
+#include <coroutine/linux.h>
+#include <coroutine/return.h>
+
+using namespace std;
+using namespace coro;
+
+#if defined(__GNUC__)
+using no_return_t = coro::null_frame_t;
+#else
+using no_return_t = std::nullptr_t;
+#endif
+
+auto report_cpu(const cpu_set_t& cpus, atomic<int>& cpu, pthread_t& tid) -> no_return_t {
+    co_await run_on_cpu(cpus);
+    tid = pthread_self();
+    cpu = sched_getcpu();
+}
+
+auto report_node(uint32_t node, atomic<int>& cpu) -> no_return_t {
+    co_await run_on_numa_node(node);
+    cpu = sched_getcpu();
+}
+
+int wait_for(atomic<int>& cpu) {
+    while (cpu.load() == -1)
+        sched_yield();
+    return cpu.load();
+}
+
+int main(int, char*[]) {
+    const cpu_topology& topology = cpu_topology::current();
+    assert(topology.list().size() > 0);
+    assert(topology.nodes() > 0);
+    for (const auto& cpu : topology.list()) {
+        assert(topology.find(cpu.id) == &cpu);
+        cpu_set_t core = topology.of_core(cpu.id);
+        assert(CPU_ISSET(cpu.id, &core));
+        cpu_set_t node = topology.of_node(cpu.node);
+        assert(CPU_ISSET(cpu.id, &node));
+        cpu_set_t package = topology.of_package(cpu.package);
+        assert(CPU_ISSET(cpu.id, &package));
+    }
+
+    // the process may be restricted with cpuset. use the last allowed CPU
+    cpu_set_t allowed{};
+    assert(sched_getaffinity(0, sizeof(cpu_set_t), &allowed) == 0);
+    int target = -1;
+    for (int id = 0; id < CPU_SETSIZE; ++id)
+        if (CPU_ISSET(id, &allowed))
+            target = id;
+    assert(target != -1);
+    cpu_set_t cpus{};
+    CPU_ZERO(&cpus);
+    CPU_SET(target, &cpus);
+
+    pthread_t t1{}, t2{};
+    atomic<int> cpu = -1;
+    report_cpu(cpus, cpu, t1);
+    assert(wait_for(cpu) == target);
+    while (pthread_pool::global().idle_count() == 0) // wait for the parking
+        sched_yield();
+    cpu = -1;
+    report_cpu(cpus, cpu, t2);
+    assert(wait_for(cpu) == target);
+    assert(pthread_equal(t1, t2)); // same affinity. reused
+
+    const cpu_topology::cpu_t* info = topology.find(target);
+    assert(info != nullptr);
+    cpu_set_t node = topology.of_node(info->node);
+    cpu = -1;
+    report_node(info->node, cpu);
+    assert(CPU_ISSET(wait_for(cpu), &node));
+    return EXIT_SUCCESS;
+}
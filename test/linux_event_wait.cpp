@@ -1,6 +1,7 @@
 /**
  * @author github.com/luncliff (luncliff@gmail.com)
  */
+#include <algorithm>
 #include <array>
 
 #include <coroutine/linux.h>
@@ -0,0 +1,86 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ */
+#undef NDEBUG
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <coroutine/frame_arena.hpp>
+#include <coroutine/linux.h>
+#include <coroutine/task.hpp>
+
+using namespace std;
+using namespace coro;
+
+// suspends forever. each resume touches its own frame
+auto idle(allocator_arg_t, frame_arena&, uint64_t& counter) -> task<void> {
+    volatile uint64_t local[32]{}; // make the frame larger than a cache line
+    for (;;) {
+        local[counter % 32] = local[counter % 32] + 1;
+        ++counter;
+        co_await suspend_always{};
+    }
+}
+
+// resume all frames in the random order, then destroy them before the `release`
+void resume_all(frame_arena& arena, size_t count) {
+    uint64_t counter = 0;
+    vector<task<void>> tasks{};
+    tasks.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+        tasks.emplace_back(idle(allocator_arg, arena, counter));
+
+    vector<size_t> order(count);
+    iota(order.begin(), order.end(), 0);
+    shuffle(order.begin(), order.end(), mt19937_64{0x1234});
+
+    for (size_t i : order) // the first resume. now the frames are suspended in the loop
+        tasks[i].handle().resume();
+    for (int round = 0; round < 4; ++round)
+        for (size_t i : order)
+            tasks[i].handle().resume();
+    assert(counter == count * 5);
+
+    tasks.clear(); // destroy the frames before the `release`
+    assert(arena.live_frames() == 0);
+    arena.release();
+}
+
+int main(int, char*[]) {
+    constexpr size_t count = 10'000;
+
+    frame_arena small_pages{huge_page_source::page_size};
+    resume_all(small_pages, count);
+
+    huge_page_source pages{};
+    {
+        frame_arena arena{huge_page_source::page_size, pages.source()};
+        void* buffers[4]{};
+        for (void*& buffer : buffers) // `io_buffer_t` of a request
+            buffer = arena.allocate(1024);
+        const auto usage = pages.usage();
+        assert(usage.huge + usage.advised + usage.small == 1);
+        for (void* buffer : buffers)
+            arena.deallocate(buffer);
+        arena.release();
+        assert(pages.usage().small == 0);
+
+        resume_all(arena, count);
+    }
+    const auto usage = pages.usage();
+    assert(usage.huge == 0 && usage.advised == 0 && usage.small == 0);
+
+    void* region = pages.allocate(4096);
+    const auto inuse = pages.usage();
+    assert(inuse.huge + inuse.advised + inuse.small == 1);
+    int unknown = 0;
+    pages.deallocate(&unknown, 4096); // not from the source. ignored
+    const auto after = pages.usage();
+    assert(after.huge == inuse.huge && after.advised == inuse.advised && after.small == inuse.small);
+    pages.deallocate(region, 4096);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,85 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ */
+
+#undef NDEBUG
+#include <array>
+#include <cassert>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <coroutine/channel_shm.hpp>
+#include <coroutine/return.h>
+
+using namespace std;
+using namespace coro;
+
+struct message_t final {
+    uint64_t seq;
+    char text[24];
+};
+using channel_t = shm_channel<message_t, 16>;
+
+constexpr uint64_t count = 20'000;
+
+auto produce(channel_t& ch, bool& done) -> frame_t {
+    message_t msg{};
+    for (msg.seq = 1; msg.seq <= count; ++msg.seq) {
+        bool ok = co_await ch.write(msg);
+        assert(ok);
+    }
+    done = true;
+}
+
+auto consume(channel_t& ch, uint64_t& sum, bool& done) -> frame_t {
+    for (uint64_t i = 1; i <= count; ++i) {
+        auto [msg, ok] = co_await ch.read();
+        assert(ok);
+        assert(msg.seq == i); // FIFO
+        sum += msg.seq;
+    }
+    done = true;
+}
+
+/// @brief resume the parked coroutines of this process until the work is done
+void run(epoll_owner& ep, const bool& done) {
+    array<epoll_event, 4> events{};
+    while (done == false) {
+        const auto n = ep.wait(1000, events);
+        assert(n > 0); // the peer process must make progress
+        for (auto i = 0; i < n; ++i)
+            coroutine_handle<void>::from_address(events[i].data.ptr).resume();
+    }
+}
+
+int main(int, char*[]) {
+    epoll_owner ep{};
+    channel_t ch{ep};
+
+    const pid_t pid = fork();
+    assert(pid != -1);
+    if (pid == 0) {
+        // the child opens the same memory with the inherited descriptors
+        epoll_owner cep{};
+        bool done = false;
+        {
+            channel_t peer{cep, dup(ch.fd()), dup(ch.event_fd(0)), dup(ch.event_fd(1))};
+            auto frame = produce(peer, done);
+            run(cep, done);
+            frame.destroy();
+        }
+        _exit(EXIT_SUCCESS);
+    }
+
+    uint64_t sum = 0;
+    bool done = false;
+    auto frame = consume(ch, sum, done);
+    run(ep, done);
+    frame.destroy();
+    assert(sum == count * (count + 1) / 2);
+
+    int status = 0;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+    return EXIT_SUCCESS;
+}
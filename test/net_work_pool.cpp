@@ -0,0 +1,104 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ * @copyright CC BY 4.0
+ */
+#undef NDEBUG
+#include <array>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <sys/socket.h>
+
+#include <coroutine/net.h>
+#include <coroutine/return.h>
+
+using namespace std;
+using namespace coro;
+
+#if defined(__GNUC__)
+using no_return_t = coro::null_frame_t;
+#else
+using no_return_t = std::nullptr_t;
+#endif
+
+auto recv_once(uint64_t sd, io_buffer_t buf, int64_t& rsz) -> frame_t {
+    auto op = recv_stream(sd, buf, 0); // the frame holds the ticket only
+    rsz = co_await op;
+    assert(op.error() == 0);
+}
+
+auto send_once(uint64_t sd, io_buffer_t buf, int64_t& ssz) -> no_return_t {
+    ssz = co_await send_stream(sd, buf, 0);
+}
+
+void test_generation() {
+    io_work_pool pool{};
+    const auto t1 = pool.acquire();
+    assert(pool.size() == 1);
+    assert(pool.capacity() == io_work_pool::slab_size);
+    const auto token = io_work_pool::token(t1);
+    assert(io_work_pool::is_token(token));
+    assert(io_work_pool::from_token(token).index == t1.index);
+
+    pool.release(t1);
+    pool.release(t1); // stale ticket is ignored
+    assert(pool.size() == 0);
+
+    const auto t2 = pool.acquire(); // same slot, next generation
+    assert(t2.index == t1.index);
+    assert(t2.generation != t1.generation);
+    assert(pool.resolve(t1) == nullptr);
+    assert(pool.stale_count() == 1);
+    pool.release(t2);
+
+    // the slabs grow with the in-flight works
+    array<io_work_ticket, io_work_pool::slab_size + 1> tickets{};
+    for (auto& t : tickets)
+        t = pool.acquire();
+    assert(pool.capacity() == 2 * io_work_pool::slab_size);
+    for (auto& t : tickets)
+        pool.release(t);
+    assert(pool.size() == 0);
+}
+
+int main(int, char*[]) {
+    test_generation();
+
+    int sv[2]{};
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) != 0)
+        return __LINE__;
+    io_work_pool& pool = net_work_pool();
+
+    // the frame is destroyed while the recv is pending. its completion must be dropped
+    array<std::byte, 64> storage{};
+    int64_t rsz = -1, ssz = -1;
+    {
+        auto frame = recv_once(sv[0], storage, rsz);
+        assert(pool.size() == 1);
+        frame.destroy();
+        assert(pool.size() == 0);
+    }
+    array<std::byte, 16> message{};
+    memset(message.data(), 'a', message.size());
+    send_once(sv[1], message, ssz);
+    while (ssz < 0)
+        poll_net_tasks(1'000'000);
+    assert(ssz == static_cast<int64_t>(message.size()));
+    while (pool.stale_count() == 0)
+        poll_net_tasks(1'000'000);
+    assert(rsz == -1);
+
+    // the slot is reused for the next operation
+    auto frame = recv_once(sv[0], storage, rsz);
+    send_once(sv[1], message, ssz);
+    while (rsz < 0)
+        poll_net_tasks(1'000'000);
+    assert(rsz >= static_cast<int64_t>(message.size())); // may include the data of the stale completion
+    frame.destroy();
+    assert(pool.size() == 0);
+    assert(pool.capacity() == io_work_pool::slab_size);
+
+    close(sv[0]);
+    close(sv[1]);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,95 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ */
+#undef NDEBUG
+#include <atomic>
+#include <cassert>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+#include <coroutine/pthread.h>
+#include <coroutine/return.h>
+
+using namespace std;
+using namespace coro;
+
+#if defined(__GNUC__)
+using no_return_t = coro::null_frame_t;
+#else
+using no_return_t = std::nullptr_t;
+#endif
+
+/// @brief `pthread_t` can be reused after the exit. The kernel's thread id is not reused soon
+long current_thread_id() noexcept {
+    return syscall(SYS_gettid);
+}
+
+// `pthread_joiner` hits the ICE of GCC 12. Await the pooled thread directly, and wait for the `completion`
+auto report_thread(const pthread_attr_t* attr, atomic<uint32_t>& completion, long& current) -> no_return_t {
+    pthread_t tid{};
+    co_await continue_on_pooled_pthread{tid, attr, &completion};
+    current = current_thread_id();
+}
+
+auto wait_gate(atomic<uint32_t>& completion, atomic<size_t>& arrived, const atomic<bool>& gate) -> no_return_t {
+    pthread_t tid{};
+    co_await continue_on_pooled_pthread{tid, nullptr, &completion};
+    arrived.fetch_add(1);
+    while (gate.load() == false)
+        sched_yield();
+}
+
+long run_on_pool(const pthread_attr_t* attr) {
+    atomic<uint32_t> completion{};
+    long current = 0;
+    report_thread(attr, completion, current);
+    pthread_pool::wait(completion); // the thread is parked again before this returns
+    assert(current != 0);
+    return current;
+}
+
+int main(int, char*[]) {
+    pthread_pool& pool = pthread_pool::global();
+
+    const long t1 = run_on_pool(nullptr);
+    assert(t1 != current_thread_id());
+    // the previous thread is parked after the completion. it must be reused
+    const long t2 = run_on_pool(nullptr);
+    assert(t1 == t2);
+
+    // the different attribute can't share the thread
+    pthread_attr_t attr1{}, attr2{};
+    assert(pthread_attr_init(&attr1) == 0);
+    assert(pthread_attr_setstacksize(&attr1, 4 << 20) == 0);
+    assert(pthread_attr_init(&attr2) == 0);
+    assert(pthread_attr_setstacksize(&attr2, 6 << 20) == 0);
+    assert(run_on_pool(&attr1) != t1);
+
+    // fill the pool with the threads of the default attribute
+    {
+        const size_t count = pool.capacity();
+        vector<atomic<uint32_t>> completions(count);
+        atomic<size_t> arrived{};
+        atomic<bool> gate{};
+        for (auto& completion : completions)
+            wait_gate(completion, arrived, gate);
+        while (arrived.load() < count) // all of them are running at once
+            sched_yield();
+        gate = true;
+        for (auto& completion : completions)
+            pthread_pool::wait(completion);
+    }
+    assert(pool.idle_count() == pool.capacity());
+
+    // the oldest one is evicted for the new attribute. so the thread is parked and reused
+    const long t3 = run_on_pool(&attr2);
+    const long t4 = run_on_pool(&attr2);
+    assert(t3 == t4);
+    assert(pool.idle_count() == pool.capacity());
+
+    pthread_attr_destroy(&attr2);
+    pthread_attr_destroy(&attr1);
+    return EXIT_SUCCESS;
+}
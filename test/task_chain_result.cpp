@@ -0,0 +1,88 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ */
+#undef NDEBUG
+#include <cassert>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <coroutine/return.h>
+#include <coroutine/task.hpp>
+
+using namespace std;
+using namespace coro;
+
+#if defined(__GNUC__)
+using no_return_t = coro::null_frame_t;
+#else
+using no_return_t = std::nullptr_t;
+#endif
+
+auto make_text(size_t count) -> task<string> {
+    co_return string(count, 'a');
+}
+
+auto get_ref(int& value) -> task<int&> {
+    co_return value;
+}
+
+auto fail(bool raise) -> task<void> {
+    if (raise)
+        throw runtime_error{"task"};
+    co_return;
+}
+
+auto move_only() -> task<unique_ptr<int>> {
+    co_return make_unique<int>(7);
+}
+
+/// @brief each level completes synchronously. the stack must not grow with the depth
+auto depth(uint32_t n) -> task<uint32_t> {
+    if (n == 0)
+        co_return 0;
+    const uint32_t v = co_await depth(n - 1);
+    co_return v + 1;
+}
+
+auto run_all(bool& done) -> no_return_t {
+    string text = co_await make_text(3);
+    assert(text == "aaa");
+
+    int value = 1;
+    int& ref = co_await get_ref(value);
+    assert(&ref == &value);
+
+    unique_ptr<int> ptr = co_await move_only();
+    assert(ptr && *ptr == 7);
+
+    co_await fail(false);
+    bool caught = false;
+    try {
+        co_await fail(true);
+    } catch (const runtime_error&) {
+        caught = true;
+    }
+    assert(caught);
+
+    // lvalue await keeps the result in the task
+    auto t = make_text(2);
+    const string& kept = co_await t;
+    assert(kept == "aa");
+    assert(t.is_ready());
+
+    const uint32_t n = co_await depth(10'000);
+    assert(n == 10'000);
+    done = true;
+}
+
+int main(int, char*[]) {
+    bool done = false;
+    run_all(done);
+    assert(done);
+
+    // lazy. nothing runs until the `co_await`
+    auto t = make_text(1);
+    assert(t.is_ready() == false);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,147 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ */
+
+#undef NDEBUG
+#include <atomic>
+#include <cassert>
+#include <set>
+#include <thread>
+
+#include <coroutine/return.h>
+#include <coroutine/thread_pool.hpp>
+
+using namespace std;
+using namespace coro;
+
+#if defined(__GNUC__)
+using no_return_t = coro::null_frame_t;
+#else
+using no_return_t = std::nullptr_t;
+#endif
+
+auto move_to(thread_pool& pool, atomic<uint32_t>& counter, thread::id& id) -> no_return_t {
+    co_await pool.schedule();
+    id = this_thread::get_id();
+    ++counter;
+}
+
+/// @brief schedule again in the worker. it uses the local deque, and can be stolen
+auto spread(thread_pool& pool, atomic<uint32_t>& counter, uint32_t depth) -> no_return_t {
+    co_await pool.schedule();
+    if (depth > 0) {
+        spread(pool, counter, depth - 1);
+        spread(pool, counter, depth - 1);
+    }
+    ++counter;
+}
+
+auto wait_post(thread_pool& pool, atomic<void*>& waiter, thread::id& id) -> no_return_t {
+    co_await pool.schedule();
+    struct park_t final : suspend_always {
+        atomic<void*>& waiter;
+        void await_suspend(coroutine_handle<void> coro) noexcept {
+            waiter = coro.address();
+        }
+    };
+    co_await park_t{{}, waiter};
+    id = this_thread::get_id();
+}
+
+auto post_from_worker(thread_pool& pool, atomic<void*>& waiter, thread::id& id) -> no_return_t {
+    co_await pool.schedule();
+    void* frame = nullptr;
+    while ((frame = waiter.load()) == nullptr)
+        this_thread::yield();
+    id = this_thread::get_id();
+    pool.post(coroutine_handle<void>::from_address(frame)); // the LIFO slot of this worker
+}
+
+/// @brief 2 coroutines which wake each other with `post`. They occupy the LIFO slot in turn
+struct ping_pong_t final {
+    static constexpr uint32_t limit = 20'000;
+    thread_pool* pool = nullptr;
+    coroutine_handle<void> peers[2]{};
+    uint32_t rounds = 0;
+    uint32_t bystander_round = UINT32_MAX;
+};
+
+auto bounce(ping_pong_t& s, uint32_t me) -> no_return_t {
+    struct park_t final : suspend_always {
+        ping_pong_t& s;
+        uint32_t me;
+        void await_suspend(coroutine_handle<void> coro) noexcept(false) {
+            s.peers[me] = coro;
+            if (auto peer = std::exchange(s.peers[1 - me], nullptr))
+                s.pool->post(peer);
+        }
+    };
+    while (s.rounds++ < ping_pong_t::limit)
+        co_await park_t{{}, s, me};
+    if (auto peer = std::exchange(s.peers[1 - me], nullptr)) // let it end
+        s.pool->post(peer);
+}
+
+auto watch(ping_pong_t& s) -> no_return_t {
+    co_await s.pool->schedule(); // local deque of the worker
+    s.bystander_round = s.rounds;
+}
+
+auto start_ping_pong(ping_pong_t& s) -> no_return_t {
+    co_await s.pool->schedule();
+    bounce(s, 0);
+    watch(s);
+    bounce(s, 1); // posts the first one
+}
+
+void lifo_limit_prevents_starvation() {
+    ping_pong_t s{};
+    {
+        thread_pool pool{1};
+        s.pool = &pool;
+        start_ping_pong(s);
+    } // wait for the worker
+    assert(s.rounds > ping_pong_t::limit);
+    assert(s.bystander_round < ping_pong_t::limit); // didn't wait for the end of the ping-pong
+}
+
+void schedule_from_outside() {
+    atomic<uint32_t> counter{};
+    thread::id id{};
+    {
+        thread_pool pool{2};
+        move_to(pool, counter, id);
+    } // wait for the workers
+    assert(counter == 1);
+    assert(id != this_thread::get_id());
+}
+
+void schedule_in_worker() {
+    atomic<uint32_t> counter{};
+    constexpr uint32_t depth = 12; // 2^13 - 1 coroutines
+    {
+        thread_pool pool{4};
+        spread(pool, counter, depth);
+    }
+    assert(counter == (1u << (depth + 1)) - 1);
+}
+
+void post_to_lifo_slot() {
+    atomic<void*> waiter{};
+    thread::id poster{}, resumed{};
+    {
+        thread_pool pool{2};
+        wait_post(pool, waiter, resumed);
+        post_from_worker(pool, waiter, poster);
+    }
+    assert(resumed != thread::id{});
+    assert(resumed == poster); // the LIFO slot can't be stolen
+}
+
+int main(int, char*[]) {
+    schedule_from_outside();
+    schedule_in_worker();
+    post_to_lifo_slot();
+    lifo_limit_prevents_starvation();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,186 @@
+/**
+ * @author github.com/luncliff (luncliff@gmail.com)
+ */
+#undef NDEBUG
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <coroutine/return.h>
+#include <coroutine/task.hpp>
+#include <coroutine/when.hpp>
+
+using namespace std;
+using namespace coro;
+
+#if defined(__GNUC__)
+using no_return_t = coro::null_frame_t;
+#else
+using no_return_t = std::nullptr_t;
+#endif
+
+/// @brief make the next allocations fail. for the children of `when_all`/`when_any`
+/// @note  not inlined. GCC warns `malloc` and `operator delete` pair after the inlining
+bool fail_allocation = false;
+
+[[gnu::noinline]] void* operator new(size_t size) {
+    if (fail_allocation)
+        throw bad_alloc{};
+    if (void* ptr = malloc(size))
+        return ptr;
+    throw bad_alloc{};
+}
+[[gnu::noinline]] void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+[[gnu::noinline]] void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+/// @brief suspends until `open`
+class gate_t final {
+    coroutine_handle<void> waiter = nullptr;
+
+  public:
+    constexpr bool await_ready() const noexcept {
+        return false;
+    }
+    void await_suspend(coroutine_handle<void> coro) noexcept {
+        waiter = coro;
+    }
+    constexpr void await_resume() const noexcept {
+    }
+    void open() noexcept {
+        std::exchange(waiter, nullptr).resume();
+    }
+};
+
+auto after(gate_t& gate, int value) -> task<int> {
+    co_await gate;
+    co_return value;
+}
+
+auto now(string text) -> task<string> {
+    co_return text;
+}
+
+auto nothing() -> task<void> {
+    co_return;
+}
+
+auto fail() -> task<void> {
+    throw runtime_error{"when_all"};
+    co_return;
+}
+
+auto all_sync(bool& done) -> no_return_t {
+    auto [a, b, c] = co_await when_all(now("a"), now("b"), nothing());
+    assert(a == "a" && b == "b");
+    (void)c;
+    done = true;
+}
+
+auto all_async(gate_t (&gates)[3], int& sum, bool& done) -> no_return_t {
+    auto [x, y, z] = co_await when_all(after(gates[0], 1), after(gates[1], 2), after(gates[2], 3));
+    sum = x + y + z;
+    done = true;
+}
+
+auto all_range(vector<task<int>> tasks, int& sum) -> no_return_t {
+    vector<int> values = co_await when_all(std::move(tasks));
+    for (int v : values)
+        sum += v;
+}
+
+auto all_error(bool& caught) -> no_return_t {
+    try {
+        co_await when_all(now("ok"), fail());
+    } catch (const runtime_error&) {
+        caught = true;
+    }
+}
+
+/// @brief the allocation failure of the children is thrown to the awaiter, not `std::terminate`
+auto all_alloc_error(size_t& caught) -> no_return_t {
+    auto all = when_all(nothing(), now("child"));
+    auto any = when_any(nothing(), now("child"));
+    fail_allocation = true;
+    try {
+        co_await all;
+    } catch (const bad_alloc&) {
+        ++caught;
+    }
+    try {
+        co_await any;
+    } catch (const bad_alloc&) {
+        ++caught;
+    }
+    fail_allocation = false;
+}
+
+auto any_first(gate_t (&gates)[3], size_t& index, int& value) -> no_return_t {
+    auto result = co_await when_any(after(gates[0], 10), after(gates[1], 20), after(gates[2], 30));
+    index = result.index();
+    value = result.index() == 1 ? get<1>(result) : -1;
+}
+
+int main(int, char*[]) {
+    {
+        bool done = false;
+        all_sync(done);
+        assert(done);
+    }
+    {
+        gate_t gates[3]{};
+        int sum = 0;
+        bool done = false;
+        all_async(gates, sum, done);
+        gates[2].open();
+        gates[0].open();
+        assert(done == false); // only after the last one
+        gates[1].open();
+        assert(done && sum == 6);
+    }
+    {
+        gate_t gates[3]{};
+        vector<task<int>> tasks{};
+        for (auto& g : gates)
+            tasks.emplace_back(after(g, 5));
+        int sum = 0;
+        all_range(std::move(tasks), sum);
+        // resume the children in the other threads. the countdown joins them
+        vector<thread> threads{};
+        for (auto& g : gates)
+            threads.emplace_back([&g]() { g.open(); });
+        for (auto& t : threads)
+            t.join();
+        assert(sum == 15);
+    }
+    {
+        bool caught = false;
+        all_error(caught);
+        assert(caught);
+    }
+    {
+        size_t caught = 0;
+        all_alloc_error(caught);
+        assert(caught == 2);
+    }
+    {
+        gate_t gates[3]{};
+        size_t index = SIZE_MAX;
+        int value = 0;
+        any_first(gates, index, value);
+        gates[1].open();
+        assert(index == 1 && value == 20); // resumed by the first
+        gates[0].open();
+        gates[2].open(); // the last child releases the state
+        assert(index == 1);
+    }
+    return EXIT_SUCCESS;
+}